@@ -10,20 +10,30 @@
 const std::vector<DatasetConfig> REAL_DATASETS = {
     DatasetConfig("../../datasets/letter-recognition.csv", 0),    // Label in first column
     DatasetConfig("../../datasets/WineQT.csv", -2),               // Label in second to last (quality)
-    DatasetConfig("../../datasets/covtype.csv", -1)               // Label in last column
+    DatasetConfig("../../datasets/covtype.csv", -1),              // Label in last column
+    DatasetConfig("../../datasets/heart_attack_prediction_dataset.csv", -1)  // Heart Attack Risk
 };
 
 int main(int argc, char* argv[]) {
     std::cout << "========================================" << std::endl;
     std::cout << "   KNN Benchmark Suite" << std::endl;
-    std::cout << "   Comparing: KNNBasic, KNNKDTree, KNNNanoflann" << std::endl;
+    std::cout << "   Comparing: KNNBasic, KNNKDTree, RevisedKDTree, QuickNN, BlockedBruteForce, KNNNanoflann" << std::endl;
     std::cout << "========================================" << std::endl;
 
     // Create results directory if it doesn't exist
     std::filesystem::create_directories("benchmarks/results");
 
+    // --threads <n>: KNNKDTree query workers (default 1, 0 = all cores)
+    int numThreads = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            numThreads = std::stoi(argv[++i]);
+        }
+    }
+
     // Create benchmark runner
-    BenchmarkRunner runner;
+    BenchmarkRunner runner(numThreads);
 
     // Start timer
     Timer globalTimer;
@@ -4,6 +4,9 @@
 #include "benchmark_utils.h"
 #include "../../include/knn/knn_basic.h"
 #include "../../include/knn/knn_kdtree.h"
+#include "../../include/optimizations/revised_kdtree.h"
+#include "../../include/optimizations/quicknn.h"
+#include "../../include/optimizations/blocked_brute_force.h"
 #include "knn_nanoflann.h"
 #include <vector>
 #include <string>
@@ -22,7 +25,7 @@ struct DatasetConfig {
 
 /**
  * Benchmark runner for comparing KNN implementations
- * Tests: KNNBasic, KNNKDTree, and KNNNanoflann
+ * Tests: KNNBasic, KNNKDTree, RevisedKDTree, QuickNN, BlockedBruteForce, and KNNNanoflann
  */
 class BenchmarkRunner {
 private:
@@ -30,6 +33,11 @@ private:
     std::map<std::string, double> basicQueryTimes; // For speedup calculation
     int totalTests;
     int currentTest;
+    int numThreads;  // workers for KNNKDTree and BlockedBruteForce batched queries
+
+    // Majority vote over neighbor labels (RevisedKDTree has no classifier wrapper)
+    static int majorityVote(const std::vector<Point>& neighbors);
+    static int majorityVote(const std::vector<Neighbor>& neighbors, const Dataset& train);
 
     // Helper to calculate accuracy (legacy)
     double calculateAccuracy(const std::vector<Point>& train,
@@ -45,22 +53,35 @@ private:
                                                           long long& total_distance_calcs);
 
     // Single algorithm benchmark
+    // leafSize: leaf bucket size for KNNKDTree and RevisedKDTree / leaf_max_size for KNNNanoflann
+    // splitRule: k-d tree split rule for KNNKDTree
     BenchmarkResult benchmarkAlgorithm(const std::string& algorithm,
                                         const std::vector<Point>& train,
                                         const std::vector<Point>& queries,
                                         const std::string& dataset_name,
-                                        int k, int dimensions);
+                                        int k, int dimensions,
+                                        int leafSize = KDTree::DEFAULT_LEAF_SIZE,
+                                        SplitRule splitRule = SplitRule::CYCLIC);
+
+    // Loads a real dataset (at most MAX_REAL_SAMPLES rows); name is the file
+    // name without extension
+    static std::vector<Point> loadRealDataset(const DatasetConfig& dataset, std::string& name);
+    static constexpr size_t MAX_REAL_SAMPLES = 10000;
 
     // Progress reporting
     void reportProgress(const std::string& message);
 
 public:
-    BenchmarkRunner();
+    // numThreads: query workers for KNNKDTree and BlockedBruteForce (<= 0: one per core)
+    explicit BenchmarkRunner(int numThreads = 1);
 
     // Test scenarios
     void runCurseOfDimensionality();
     void runScalability();
     void runKParameterImpact();
+    void runLeafSizeImpact();
+    void runPointCloudBatch();
+    void runSplitRules(const std::vector<DatasetConfig>& datasets);
     void runRealDatasets(const std::vector<DatasetConfig>& datasets);
 
     // Execute all benchmarks
@@ -15,6 +15,8 @@ struct BenchmarkResult {
     int n_dimensions;
     int k_neighbors;
     int n_queries;
+    int leaf_size;        // 0 if not applicable
+    int n_threads;        // query worker threads
     double build_time_ms;
     double total_query_time_ms;
     double avg_query_time_ms;
@@ -29,6 +31,10 @@ struct BenchmarkResult {
     // Distance calculation metrics
     long long total_distance_calculations;
     double avg_distance_calculations_per_query;
+
+    // k-d tree build rule and search effort (KNNKDTree only)
+    std::string split_rule;             // empty if not applicable
+    double avg_node_visits_per_query;   // -1.0 if not applicable
 };
 
 // Benchmark suite info
@@ -86,6 +92,7 @@ private:
     static void writeRealDatasetMetrics(std::ofstream& file, const std::vector<BenchmarkResult>& results);
     static void writeSpeedupTable(std::ofstream& file, const std::vector<BenchmarkResult>& results);
     static void writeDistanceCalculationMetrics(std::ofstream& file, const std::vector<BenchmarkResult>& results);
+    static void writeSplitRuleMetrics(std::ofstream& file, const std::vector<BenchmarkResult>& results);
 };
 
 // High-resolution timer utility
@@ -19,6 +19,7 @@ private:
     std::vector<int> trainingLabels;
     int k;
     int dimensions;
+    int leafMaxSize;
 
     // Adapter for nanoflann
     struct PointCloudAdapter {
@@ -43,7 +44,8 @@ private:
     mutable long long distance_count;  // Manual counter for nanoflann
 
 public:
-    KNNNanoflann(int k_neighbors, int dims);
+    // leafMaxSize: nanoflann's leaf_max_size (comparable to KNNKDTree's leafSize)
+    KNNNanoflann(int k_neighbors, int dims, int leafMaxSize = 10);
     ~KNNNanoflann();
 
     void fit(const std::vector<Point>& data);
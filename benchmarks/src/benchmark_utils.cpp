@@ -229,6 +229,12 @@ void JSONWriter::writeBenchmarkResults(const std::string& filepath,
         file << "      \"n_dimensions\": " << r.n_dimensions << ",\n";
         file << "      \"k_neighbors\": " << r.k_neighbors << ",\n";
         file << "      \"n_queries\": " << r.n_queries << ",\n";
+        if (r.leaf_size > 0) {
+            file << "      \"leaf_size\": " << r.leaf_size << ",\n";
+        } else {
+            file << "      \"leaf_size\": null,\n";
+        }
+        file << "      \"n_threads\": " << r.n_threads << ",\n";
         file << "      \"build_time_ms\": " << r.build_time_ms << ",\n";
         file << "      \"total_query_time_ms\": " << r.total_query_time_ms << ",\n";
         file << "      \"avg_query_time_ms\": " << r.avg_query_time_ms << ",\n";
@@ -261,7 +267,16 @@ void JSONWriter::writeBenchmarkResults(const std::string& filepath,
 
         // Distance calculation metrics
         file << "      \"total_distance_calculations\": " << r.total_distance_calculations << ",\n";
-        file << "      \"avg_distance_calculations_per_query\": " << r.avg_distance_calculations_per_query << "\n";
+        file << "      \"avg_distance_calculations_per_query\": " << r.avg_distance_calculations_per_query << ",\n";
+
+        // k-d tree split rule metrics
+        if (!r.split_rule.empty()) {
+            file << "      \"split_rule\": \"" << escapeJSON(r.split_rule) << "\",\n";
+            file << "      \"avg_node_visits_per_query\": " << r.avg_node_visits_per_query << "\n";
+        } else {
+            file << "      \"split_rule\": null,\n";
+            file << "      \"avg_node_visits_per_query\": null\n";
+        }
 
         file << "    }" << (i < results.size() - 1 ? "," : "") << "\n";
     }
@@ -320,6 +335,10 @@ void CSVWriter::writeComprehensiveResults(const std::string& filepath,
 
     // Write distance calculation metrics
     writeDistanceCalculationMetrics(file, results);
+    file << "\n\n";
+
+    // Write split rule metrics
+    writeSplitRuleMetrics(file, results);
 
     file.close();
     std::cout << "Comprehensive CSV results saved to: " << filepath << std::endl;
@@ -349,7 +368,13 @@ void CSVWriter::writeSyntheticMetrics(std::ofstream& file, const std::vector<Ben
         // Filter synthetic results
         if (r.dataset_name.find("synthetic") != std::string::npos) {
             std::string test_type;
-            if (r.dataset_name.find("_d") != std::string::npos) {
+            if (r.dataset_name.find("_split") != std::string::npos) {
+                test_type = "Split_Rule";
+            } else if (r.dataset_name.find("_leaf") != std::string::npos) {
+                test_type = "Leaf_Size";
+            } else if (r.dataset_name.find("_cloud") != std::string::npos) {
+                test_type = "Point_Cloud_Batch";
+            } else if (r.dataset_name.find("_d") != std::string::npos) {
                 test_type = "Curse_of_Dimensionality";
             } else if (r.dataset_name.find("_n") != std::string::npos) {
                 test_type = "Scalability";
@@ -450,6 +475,28 @@ void CSVWriter::writeDistanceCalculationMetrics(std::ofstream& file, const std::
     }
 }
 
+void CSVWriter::writeSplitRuleMetrics(std::ofstream& file, const std::vector<BenchmarkResult>& results) {
+    file << "# TABLE 5: K-D TREE SPLIT RULES\n";
+    file << "Dataset,Split_Rule,Dimensions,Samples,K,Build_Time_ms,Avg_Query_Time_ms,Node_Visits_Per_Query,Dist_Calc_Per_Query\n";
+
+    for (const auto& r : results) {
+        // Only the split rule scenario compares rules
+        if (r.dataset_name.find("_split") == std::string::npos || r.split_rule.empty()) {
+            continue;
+        }
+
+        file << r.dataset_name << ","
+             << r.split_rule << ","
+             << r.n_dimensions << ","
+             << r.n_samples << ","
+             << r.k_neighbors << ","
+             << r.build_time_ms << ","
+             << r.avg_query_time_ms << ","
+             << r.avg_node_visits_per_query << ","
+             << r.avg_distance_calculations_per_query << "\n";
+    }
+}
+
 // MetricsCalculator Implementation
 double MetricsCalculator::calculateAccuracy(const std::vector<int>& true_labels,
                                             const std::vector<int>& predicted_labels) {
@@ -3,8 +3,9 @@
 #include <map>
 #include <cmath>
 
-KNNNanoflann::KNNNanoflann(int k_neighbors, int dims)
-    : k(k_neighbors), dimensions(dims), adapter(nullptr), kdtree(nullptr), distance_count(0) {}
+KNNNanoflann::KNNNanoflann(int k_neighbors, int dims, int leafMaxSize)
+    : k(k_neighbors), dimensions(dims), leafMaxSize(leafMaxSize),
+      adapter(nullptr), kdtree(nullptr), distance_count(0) {}
 
 KNNNanoflann::~KNNNanoflann() {
     if (kdtree) delete kdtree;
@@ -25,7 +26,7 @@ void KNNNanoflann::fit(const std::vector<Point>& data) {
     if (kdtree) delete kdtree;
 
     adapter = new PointCloudAdapter(trainingData);
-    kdtree = new KDTreeType(dimensions, *adapter, nanoflann::KDTreeSingleIndexAdaptorParams(10));
+    kdtree = new KDTreeType(dimensions, *adapter, nanoflann::KDTreeSingleIndexAdaptorParams(leafMaxSize));
     kdtree->buildIndex();
 }
 
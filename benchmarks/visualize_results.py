@@ -23,7 +23,7 @@ def plot_curse_of_dimensionality(results, output_dir='build/benchmarks/results/p
     cod_results = [r for r in results if 'synthetic_' in r['dataset_name']
                    and r['dataset_name'].endswith('d')]
 
-    algorithms = ['KNNBasic', 'KNNKDTree', 'KNNNanoflann']
+    algorithms = ['KNNBasic', 'KNNKDTree', 'RevisedKDTree', 'BlockedBruteForce', 'KNNNanoflann']
     dimensions = sorted(list(set([r['n_dimensions'] for r in cod_results])))
 
     plt.figure(figsize=(12, 6))
@@ -45,7 +45,7 @@ def plot_curse_of_dimensionality(results, output_dir='build/benchmarks/results/p
 
     # Plot 2: Speedup vs Basic
     plt.subplot(1, 2, 2)
-    for algo in ['KNNKDTree', 'KNNNanoflann']:
+    for algo in ['KNNKDTree', 'RevisedKDTree', 'BlockedBruteForce', 'KNNNanoflann']:
         speedups = [r['speedup_vs_basic'] for r in cod_results
                    if r['algorithm'] == algo]
         speedups = sorted(speedups, key=lambda x: dimensions)
@@ -70,7 +70,7 @@ def plot_scalability(results, output_dir='build/benchmarks/results/plots'):
     # Filter results for scalability test
     scal_results = [r for r in results if 'synthetic_n' in r['dataset_name']]
 
-    algorithms = ['KNNBasic', 'KNNKDTree', 'KNNNanoflann']
+    algorithms = ['KNNBasic', 'KNNKDTree', 'RevisedKDTree', 'BlockedBruteForce', 'KNNNanoflann']
     sample_sizes = sorted(list(set([r['n_samples'] for r in scal_results])))
 
     plt.figure(figsize=(12, 6))
@@ -95,7 +95,7 @@ def plot_scalability(results, output_dir='build/benchmarks/results/plots'):
 
     # Plot 2: Build time vs dataset size
     plt.subplot(1, 2, 2)
-    for algo in ['KNNKDTree', 'KNNNanoflann']:
+    for algo in ['KNNKDTree', 'RevisedKDTree', 'KNNNanoflann']:
         build_times = []
         for n in sample_sizes:
             res = [r for r in scal_results if r['algorithm'] == algo and r['n_samples'] == n]
@@ -123,7 +123,7 @@ def plot_k_parameter_impact(results, output_dir='build/benchmarks/results/plots'
     # Filter results for K parameter test
     k_results = [r for r in results if 'synthetic_k' in r['dataset_name']]
 
-    algorithms = ['KNNBasic', 'KNNKDTree', 'KNNNanoflann']
+    algorithms = ['KNNBasic', 'KNNKDTree', 'RevisedKDTree', 'KNNNanoflann']
     k_values = sorted(list(set([r['k_neighbors'] for r in k_results])))
 
     plt.figure(figsize=(10, 6))
@@ -148,6 +148,40 @@ def plot_k_parameter_impact(results, output_dir='build/benchmarks/results/plots'
     print(f"Saved: {output_dir}/k_parameter_impact.png")
     plt.close()
 
+def plot_point_cloud_batch(results, output_dir='build/benchmarks/results/plots'):
+    """Plot 3D point cloud throughput as the number of queries per frame grows"""
+    Path(output_dir).mkdir(parents=True, exist_ok=True)
+
+    # Filter results for point cloud batch test
+    cloud_results = [r for r in results if 'synthetic_cloud3d' in r['dataset_name']]
+    if not cloud_results:
+        return
+
+    algorithms = ['KNNKDTree', 'RevisedKDTree', 'QuickNN', 'KNNNanoflann']
+    query_counts = sorted(list(set([r['n_queries'] for r in cloud_results])))
+
+    plt.figure(figsize=(10, 6))
+
+    for algo in algorithms:
+        times = []
+        for q in query_counts:
+            res = [r for r in cloud_results if r['algorithm'] == algo and r['n_queries'] == q]
+            if res:
+                times.append(res[0]['total_query_time_ms'])
+        if times:
+            plt.plot(query_counts[:len(times)], times, label=algo, marker='o', linewidth=2)
+
+    plt.xlabel('Queries per Frame', fontsize=12)
+    plt.ylabel('Total Query Time (ms)', fontsize=12)
+    plt.title('3D Point Cloud - Batched k-NN', fontsize=14, fontweight='bold')
+    plt.legend()
+    plt.grid(True, alpha=0.3)
+
+    plt.tight_layout()
+    plt.savefig(f'{output_dir}/point_cloud_batch.png', dpi=300)
+    print(f"Saved: {output_dir}/point_cloud_batch.png")
+    plt.close()
+
 def plot_distance_calculations_real_datasets(results, output_dir='build/benchmarks/results/plots'):
     """Plot average distance calculations per algorithm for real datasets"""
     Path(output_dir).mkdir(parents=True, exist_ok=True)
@@ -174,6 +208,7 @@ def plot_distance_calculations_real_datasets(results, output_dir='build/benchmar
                 'dimensions': r['n_dimensions'],
                 'KNNBasic': [],
                 'KNNKDTree': [],
+                'RevisedKDTree': [],
                 'KNNNanoflann': []
             }
 
@@ -186,6 +221,7 @@ def plot_distance_calculations_real_datasets(results, output_dir='build/benchmar
     dataset_dims = []
     basic_avgs = []
     kdtree_avgs = []
+    revised_avgs = []
     nano_avgs = []
 
     for name, data in sorted(datasets.items()):
@@ -194,17 +230,19 @@ def plot_distance_calculations_real_datasets(results, output_dir='build/benchmar
 
         basic_avgs.append(np.mean(data['KNNBasic']) if data['KNNBasic'] else 0)
         kdtree_avgs.append(np.mean(data['KNNKDTree']) if data['KNNKDTree'] else 0)
+        revised_avgs.append(np.mean(data['RevisedKDTree']) if data['RevisedKDTree'] else 0)
         nano_avgs.append(np.mean(data['KNNNanoflann']) if data['KNNNanoflann'] else 0)
 
     # Create bar plot
     x = np.arange(len(dataset_names))
-    width = 0.25
+    width = 0.2
 
     fig, ax = plt.subplots(figsize=(14, 8))
 
-    bars1 = ax.bar(x - width, basic_avgs, width, label='KNNBasic', color='#e74c3c', alpha=0.8)
-    bars2 = ax.bar(x, kdtree_avgs, width, label='KNNKDTree', color='#3498db', alpha=0.8)
-    bars3 = ax.bar(x + width, nano_avgs, width, label='KNNNanoflann', color='#2ecc71', alpha=0.8)
+    bars1 = ax.bar(x - 1.5 * width, basic_avgs, width, label='KNNBasic', color='#e74c3c', alpha=0.8)
+    bars2 = ax.bar(x - 0.5 * width, kdtree_avgs, width, label='KNNKDTree', color='#3498db', alpha=0.8)
+    bars4 = ax.bar(x + 0.5 * width, revised_avgs, width, label='RevisedKDTree', color='#9b59b6', alpha=0.8)
+    bars3 = ax.bar(x + 1.5 * width, nano_avgs, width, label='KNNNanoflann', color='#2ecc71', alpha=0.8)
 
     ax.set_xlabel('Dataset (Dimensions)', fontsize=13, fontweight='bold')
     ax.set_ylabel('Avg Distance Calculations per Query', fontsize=13, fontweight='bold')
@@ -229,6 +267,7 @@ def plot_distance_calculations_real_datasets(results, output_dir='build/benchmar
 
     add_labels(bars1)
     add_labels(bars2)
+    add_labels(bars4)
     add_labels(bars3)
 
     plt.tight_layout()
@@ -294,6 +333,7 @@ def main():
     plot_curse_of_dimensionality(results)
     plot_scalability(results)
     plot_k_parameter_impact(results)
+    plot_point_cloud_batch(results)
     plot_distance_calculations_real_datasets(results)
 
     print("\nGenerating LaTeX table...")
@@ -7,16 +7,30 @@
  * KDNode - Node structure for k-d tree
  * Based on: Bentley, J. L. (1975) "Multidimensional binary search trees
  * used for associative searching"
+ *
+ * Nodes live in their tree's NodeArena: each record holds the node followed
+ * by its k coordinates, so a node and its key share cache lines. Nodes own
+ * no heap memory and are never deleted one by one; the arena frees them.
  */
 class KDNode {
 public:
-    Point point;       // k-dimensional point with label
+    double* point;     // k coordinates of the point, stored after the node
+    int label;         // label of the point (-1 if unlabeled)
     int disc;          // discriminator (0 to k-1)
     KDNode* loson;     // left subtree (lesser values)
     KDNode* hison;     // right subtree (greater values)
+    int index;         // position of point in the tree's input sequence
 
-    KDNode(const Point& p, int d);
-    ~KDNode();
+    // Constructed in place in an arena record of recordSize(dims) bytes
+    KDNode(const double* coords, int dims, int label, int d, int index = -1);
+
+    // Copies the point (coordinates and label) of another node
+    void assignPoint(const KDNode& other, int dims);
+    Point toPoint(int dims) const;
+    bool hasCoordinates(const double* coords, int dims) const;
+
+    // Bytes of an arena record for a node of dims coordinates
+    static size_t recordSize(int dims);
 };
 
 #endif // KDNODE_H
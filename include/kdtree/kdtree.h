@@ -2,10 +2,37 @@
 #define KDTREE_H
 
 #include "kdnode.h"
+#include "node_arena.h"
 #include "../utils/point.h"
+#include "../utils/dataset.h"
 #include "../utils/distance_metrics.h"
+#include "../utils/knearest_set.h"
+#include "../utils/neighbor.h"
+#include "../utils/precision.h"
+#include "../utils/array_view.h"
+#include "../utils/mapped_file.h"
+#include <atomic>
+#include <memory>
+#include <string>
 #include <vector>
 
+/**
+ * How a bulk build chooses each split of the compact index
+ * - CYCLIC: Bentley's NEXTDISC rotation, split at the median (default)
+ * - HIGHEST_VARIANCE: axis of largest variance, split at the median
+ * - WIDEST_SPREAD: axis of largest max - min, split at the median
+ * - SLIDING_MIDPOINT: longest side of the cell, split at its midpoint; if
+ *   all points fall on one side the split slides to the nearest point
+ *   (Maneewongvatana & Mount), so cells stay fat on skewed data
+ * The data-driven rules help when a few features dominate the spread.
+ */
+enum class SplitRule {
+    CYCLIC,
+    HIGHEST_VARIANCE,
+    WIDEST_SPREAD,
+    SLIDING_MIDPOINT
+};
+
 /**
  * KDTree - k-dimensional tree implementation
  * Based on: Bentley, J. L. (1975) "Multidimensional binary search trees
@@ -15,67 +42,300 @@
  * - INSERT (Algorithm I)
  * - DELETE (Algorithm D)
  * - SEARCH
+ * - Balanced bulk build (median partitioning, "optimized" k-d tree)
  * - Nearest neighbor search
+ *
+ * build() produces a compact, pointer-free index: nodes are stored in one
+ * contiguous array in preorder, points are kept in leaf buckets of up to
+ * leafSize points and coordinates live in a separate structure-of-arrays
+ * buffer. INSERT and DELETE on a built tree first convert it back to linked
+ * KDNodes. Searches over the compact index are instantiated per metric policy
+ * and, for common dimensions (see Dimensions::withDimensions), per number of
+ * axes, so leaf distance loops fully unroll. The index can store float32
+ * coordinates (see Precision), halving its memory. The split of each index
+ * node follows a SplitRule; INSERT and DELETE work on Bentley's cyclic tree.
+ *
+ * A built index can be saved to a binary file and loaded back with its
+ * configuration. load() maps the file and searches read the arrays in place,
+ * so reopening an index costs neither parsing nor rebuilding.
  */
 class KDTree {
 private:
     int k;              // number of dimensions
     KDNode* root;
-    mutable int distance_calc_count;  // Track distance calculations
+    NodeArena arena;    // storage of the linked tree's nodes
+    mutable std::atomic<long long> distance_calc_count;  // Track distance calculations
+    mutable std::atomic<long long> node_visit_count;     // Index nodes visited by searches
     DistanceType distanceMetric;      // Distance metric to use
     double minkowskiP;                // Parameter for Minkowski distance
+    int nextIndex;                    // index given to the next inserted point
 
     // Algorithm functions from Bentley 1975
     int nextdisc(int disc);
     std::vector<double> superkey(const Point& point, int j);
 
+    int compareSuperkey(const Point& a, const Point& b, int j) const;
+    int compareSuperkey(const double* a, const double* b, int j) const;
+
     enum SuccessorResult { LOSON, HISON, EQUAL };
     SuccessorResult successor(KDNode* node, const Point& point);
 
+    KDNode* newNode(const double* coords, int label, int disc, int index);
+    void clearNodes();  // Drops the linked tree (and its arena slabs)
+
+    // Balanced bulk build helper (median of the superkey order at each level)
+    // order holds positions in points; ids gives each point's index
+    KDNode* buildRec(const std::vector<Point>& points, const std::vector<int>& ids,
+                     std::vector<int>& order, size_t begin, size_t end, int disc);
+    int heightRec(KDNode* node) const;
+
+    // Compact index node. Inner nodes split on disc at split, with the left
+    // subtree at i + 1 and the right subtree at hison. Leaves (disc == -1)
+    // own the bucket [begin, end) of the coordinate columns.
+    struct FlatNode {
+        double split;   // discriminating key value
+        int disc;       // discriminator, -1 for leaves
+        int hison;      // index of right subtree in nodes
+        int begin;      // leaf bucket range
+        int end;
+    };
+
+    int leafSize;                   // maximum number of points in a leaf bucket
+    Precision precision;            // coordinate storage and distance accumulation
+    SplitRule splitRule;            // split choice of bulk builds
+
+    // The compact index is read through views: of the vectors below after
+    // build(), or of the mapped file after load()
+    ArrayView<FlatNode> nodes;      // preorder, root at 0
+    ArrayView<double> columns;      // axis d of point i at columns[d * labels.size() + i]
+    ArrayView<float> floatColumns;  // same layout, used instead of columns for float32
+    ArrayView<int> labels;          // label of point i
+    ArrayView<int> ids;             // index of point i in the build() input
+    ArrayView<int> slots;           // point of each build() input; -2 - point for dropped duplicates
+
+    std::vector<FlatNode> nodeStore;
+    std::vector<double> columnStore;
+    std::vector<float> floatColumnStore;
+    std::vector<int> labelStore;
+    std::vector<int> idStore;
+    std::vector<int> slotStore;
+    std::unique_ptr<MappedFile> mapping;  // file of a loaded index
+
+    void viewStore();   // Points the views at the owned vectors
+    void clearIndex();  // Drops the compact index, owned or mapped
+
+    bool indexed() const { return !nodes.empty(); }
+    bool floatStorage() const { return precision != Precision::FLOAT64; }
+    template <class T>
+    const T* column(int d) const;   // axis d of the stored coordinates (T matches the storage)
+    double coordinate(int d, int i) const;
+    double stored(double x) const;  // x rounded to the storage precision
+    // rows[i] points at the coordinates of input i; order lists the inputs to index
+    void buildIndex(const std::vector<const double*>& rows, const std::vector<int>& rowLabels,
+                    std::vector<int>& order, int numThreads);
+
+    // A range of order to build a subtree from; low/high bound its cell
+    // (SLIDING_MIDPOINT only)
+    struct BuildTask {
+        size_t begin;
+        size_t end;
+        int disc;       // discriminator under the CYCLIC rule
+        std::vector<double> low;
+        std::vector<double> high;
+    };
+    // Top levels of a parallel build in preorder: split nodes, and the
+    // subtree built by tasks[task] where task >= 0
+    struct BuildPiece {
+        FlatNode node;
+        int task;
+    };
+    // Split of a range: [begin, mid) keys <= value <= keys of [mid, end)
+    struct Split {
+        int disc;
+        size_t mid;
+        double value;
+    };
+    static constexpr size_t PARALLEL_SPLIT_MIN = 1 << 15;  // smallest range split in parallel
+
+    // Per-axis min and max of a range, plus sum and sum of squares relative
+    // to shift (the first point) for variances
+    struct AxisStats {
+        std::vector<double> low, high, sum, sumSq;
+    };
+    AxisStats axisStats(const std::vector<const double*>& rows, const std::vector<int>& order,
+                        size_t begin, size_t end, int numThreads) const;
+    // Chooses the split of [begin, end) and partitions order around it
+    Split partition(const std::vector<const double*>& rows, std::vector<int>& order,
+                    size_t begin, size_t end, int disc, const std::vector<double>& low,
+                    const std::vector<double>& high, int numThreads);
+    void splitTopLevels(const std::vector<const double*>& rows, std::vector<int>& order,
+                        BuildTask task, int numThreads, std::vector<BuildTask>& tasks,
+                        std::vector<BuildPiece>& pieces);
+    size_t placePieces(const std::vector<BuildPiece>& pieces,
+                       const std::vector<std::vector<FlatNode>>& subtrees, size_t p);
+    int buildFlatRec(const std::vector<const double*>& rows, std::vector<int>& order,
+                     size_t begin, size_t end, int disc, std::vector<double>& low,
+                     std::vector<double>& high, std::vector<FlatNode>& out);
+    Point pointAt(int i) const;
+    bool searchFlat(int i, const Point& point) const;
+    int heightFlat(int i) const;
+    void inorderFlat(int i) const;
+    void unflatten();   // Convert the compact index back to linked KDNodes
+
     // Helper functions
     KDNode* findMin(KDNode* node, int dim, int currentDisc);
-    KDNode* findMax(KDNode* node, int dim, int currentDisc);
+    // Throws std::invalid_argument unless a query has dims == k axes
+    void checkQuery(size_t dims) const;
     KDNode* deleteNode(KDNode* node, const Point& point);
     KDNode* searchRec(KDNode* node, const Point& point);
     void inorderRec(KDNode* node);
 
-    // Nearest neighbor search
-    double distance(const Point& a, const Point& b);
-    void nearestNeighborRec(KDNode* node, const Point& target,
-                           Point& best, double& bestDist);
-
-    // k-NN search helper
-    struct NeighborCandidate {
-        Point point;
-        double distance;
-
-        bool operator<(const NeighborCandidate& other) const {
-            return distance < other.distance;
-        }
+    // Nearest neighbor search (in reduced distance space, see DistanceMetrics)
+    // Searches only read the tree and count distances into a caller-owned
+    // counter, so concurrent queries never share mutable state. They are
+    // templates over a metric policy (see metric_policies.h), resolved from
+    // distanceMetric once per query.
+    template <class Metric>
+    void nearestNeighborRec(KDNode* node, const Point& target, Point& best, double& bestDist,
+                            long long& distances, const Metric& metric) const;
+
+    // k-NN search helper (rd: reduced distance from target to the node's cell)
+    template <class Metric>
+    void kNearestRec(KDNode* node, const Point& target, double rd,
+                     std::vector<double>& offsets, KNearestSet<const KDNode*>& candidates,
+                     long long& distances, const Metric& metric) const;
+
+    // Per-query state of a k-NN search over the compact index
+    struct SearchState {
+        const double* target;
+        KNearestSet<int> candidates;
+        std::vector<double> offsets;    // per-axis offset from target to the current cell
+        std::vector<double> scratch;    // leaf bucket distances
+        std::vector<float> floatScratch;  // the same, for float32 accumulation
+        long long distances;            // distance calculations of this query
+        long long visits;               // index nodes visited by this query
+
+        SearchState(const double* target, int k, int dims, int leafSize, Precision precision)
+            : target(target), candidates(k), offsets(dims, 0.0), scratch(leafSize),
+              floatScratch(precision == Precision::FLOAT32 ? leafSize : 0), distances(0),
+              visits(0) {}
     };
 
-    void kNearestRec(KDNode* node, const Point& target,
-                    std::vector<NeighborCandidate>& candidates, int k);
+    // D is the number of axes fixed at compile time, or Dimensions::DYNAMIC;
+    // T is the storage type and Acc the accumulation type
+    template <int D, class T, class Acc, class Metric>
+    void leafDistances(SearchState& state, const FlatNode& leaf, const Metric& metric) const;
+    template <int D, class T, class Acc, class Metric>
+    void kNearestFlat(int i, double rd, SearchState& state, const Metric& metric) const;
+    template <int D, class T, class Acc>
+    void kNearestFlatRoot(SearchState& state) const;
+
+    // Whole-tree search, specialized for the tree's dimension when it is a
+    // common one and for its precision (picked once, in the constructor) and
+    // for its metric
+    using FlatSearch = void (KDTree::*)(SearchState&) const;
+    FlatSearch flatSearch;
+    void kNearestFlat(SearchState& state) const {
+        (this->*flatSearch)(state);
+        node_visit_count.fetch_add(state.visits, std::memory_order_relaxed);
+    }
+    std::vector<Neighbor> toNeighbors(const std::vector<KNearestSet<int>::Entry>& found) const;
 
 public:
-    KDTree(int dimensions, DistanceType metric = DistanceType::EUCLIDEAN, double p = 2.0);
+    static constexpr int DEFAULT_LEAF_SIZE = 10;
+
+    // leafSize: maximum number of points per leaf bucket of a built tree
+    // precision: storage of the built index; coordinates are rounded to it,
+    // including those of points later returned or converted back by insert()
+    // and remove()
+    // splitRule: split choice of build()
+    KDTree(int dimensions, DistanceType metric = DistanceType::EUCLIDEAN, double p = 2.0,
+           int leafSize = DEFAULT_LEAF_SIZE, Precision precision = Precision::FLOAT64,
+           SplitRule splitRule = SplitRule::CYCLIC);
     ~KDTree();
 
     // Main operations
     bool insert(const Point& point);
+
+    // Bulk build, replacing the tree contents, on numThreads workers (<= 0:
+    // one per core). The Dataset overload indexes rows without per-point
+    // copies. Splits and buckets do not depend on the thread count.
+    void build(const std::vector<Point>& points, int numThreads = 0);
+    void build(const Dataset& data, int numThreads = 0);
     bool search(const Point& point);
     void remove(const Point& point);
     void inorder();
+    int height() const;
+    size_t nodeBytes() const { return arena.bytes(); }  // Memory held by linked nodes
+    int getLeafSize() const { return leafSize; }
+    Precision getPrecision() const { return precision; }
+    SplitRule getSplitRule() const { return splitRule; }
+    size_t indexBytes() const;  // Memory held (or mapped) by the compact index
+    int getDimensions() const { return k; }
+    DistanceType getDistanceMetric() const { return distanceMetric; }
+    double getMinkowskiP() const { return minkowskiP; }
+    bool hasIndex() const { return indexed(); }
+
+    // Label of the indexed point with the given build() input index, as
+    // returned by searches of the compact index
+    int labelOf(int index) const { return labels[slots[index]]; }
+
+    // Point of the compact index with the given build() input index; false
+    // if there is no index, no such input, or it was dropped as a duplicate
+    bool pointOf(int index, Point& point) const;
+
+    // Number of other build() inputs dropped as duplicates of the point with
+    // the given input index (0 if it was itself dropped or is not indexed)
+    int duplicatesOf(int index) const;
+
+    // Writes the compact index and the tree's configuration to a binary file
+    // (native byte order). Throws std::runtime_error if the tree has no
+    // compact index (never built, or changed by insert() / remove() since)
+    // or the file cannot be written.
+    void save(const std::string& path) const;
+
+    // Opens a file written by save(). The file is mapped and must stay
+    // unchanged while the tree uses it; insert() and remove() copy the index
+    // out first. Throws std::runtime_error for unreadable, truncated or
+    // incompatible files.
+    static std::unique_ptr<KDTree> load(const std::string& path);
+
+    // Searches throw std::invalid_argument for a query whose dimension is
+    // not the tree's
 
     // Nearest neighbor search
-    Point nearestNeighbor(const Point& target);
+    Point nearestNeighbor(const Point& target) const;
 
     // k-NN search - find k nearest neighbors
-    std::vector<Point> kNearestNeighbors(const Point& target, int k);
+    std::vector<Point> kNearestNeighbors(const Point& target, int k) const;
+
+    // k-NN search counting into distances instead of the tree's counter
+    std::vector<Point> kNearestNeighbors(const Point& target, int k, long long& distances) const;
+
+    // k-NN search returning (index, distance) pairs, nearest first, without
+    // copying coordinates. index is the point's position in the build() input;
+    // each insert() call takes the next index. Points and Dataset rows both
+    // convert to RowView.
+    std::vector<Neighbor> kNearestNeighborIndices(RowView target, int k) const;
+    std::vector<Neighbor> kNearestNeighborIndices(RowView target, int k, long long& distances) const;
+
+    // Batched k-NN search on numThreads workers (<= 0: one per core).
+    // Result i belongs to queries[i]; per-thread distance counts are merged
+    // into the tree's counter once the batch is done.
+    std::vector<std::vector<Point>> kNearestNeighborsBatch(const std::vector<Point>& queries,
+                                                           int k, int numThreads = 0) const;
+    std::vector<std::vector<Neighbor>> kNearestNeighborIndicesBatch(const std::vector<Point>& queries,
+                                                                    int k, int numThreads = 0) const;
+    std::vector<std::vector<Neighbor>> kNearestNeighborIndicesBatch(const Dataset& queries,
+                                                                    int k, int numThreads = 0) const;
 
     // Get distance calculations count (for metrics)
     void resetDistanceCount() { distance_calc_count = 0; }
-    int getDistanceCount() const { return distance_calc_count; }
+    long long getDistanceCount() const { return distance_calc_count; }
+
+    // Nodes (inner and leaf) of the compact index visited by searches
+    void resetNodeVisitCount() { node_visit_count = 0; }
+    long long getNodeVisitCount() const { return node_visit_count; }
 };
 
 #endif // KDTREE_H
@@ -0,0 +1,53 @@
+#ifndef NODE_ARENA_H
+#define NODE_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/**
+ * Arena of fixed-size records, carved from large slabs
+ * Records are handed out in allocation order from the current slab, so a
+ * tree built in one pass sits contiguously in memory in build order.
+ * Released records go on a free list and are reused first. Nothing is
+ * returned to the heap until clear() or destruction, which free every slab
+ * at once: O(number of slabs), so only trivially destructible objects
+ * belong in an arena.
+ */
+class NodeArena {
+public:
+    static constexpr size_t DEFAULT_SLAB_BYTES = 64 * 1024;
+
+    // recordSize is rounded up so every record is aligned for any type
+    explicit NodeArena(size_t recordSize, size_t slabBytes = DEFAULT_SLAB_BYTES);
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    void* allocate();
+    void release(void* record);     // Record goes on the free list
+    void reserve(size_t count);     // The next count allocations share one slab
+    void clear();                   // Frees all slabs; every record becomes invalid
+
+    size_t getRecordSize() const { return recordSize; }
+    size_t liveRecords() const { return live; }
+    size_t slabCount() const { return slabs.size(); }
+    size_t bytes() const { return slabBytesTotal; }   // Memory held by the slabs
+
+private:
+    struct FreeRecord {
+        FreeRecord* next;
+    };
+
+    size_t recordSize;
+    size_t slabRecords;             // records per regular slab
+    std::vector<std::unique_ptr<char[]>> slabs;
+    char* cursor;                   // next unused record of the newest slab
+    char* slabEnd;
+    FreeRecord* freeList;
+    size_t live;
+    size_t slabBytesTotal;
+
+    void addSlab(size_t records);
+};
+
+#endif // NODE_ARENA_H
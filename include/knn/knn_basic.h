@@ -1,31 +1,97 @@
 #ifndef KNN_BASIC_H
 #define KNN_BASIC_H
 
+#include <string>
 #include <vector>
 #include "../utils/point.h"
+#include "../utils/dataset.h"
+#include "../utils/dataset_loader.h"
 #include "../utils/distance_metrics.h"
+#include "../utils/neighbor.h"
+#include "../utils/precision.h"
+#include "../utils/aligned_allocator.h"
+#include "../utils/knearest_set.h"
 
 /**
  * Classic k-NN implementation (brute force)
  * Baseline for comparison with optimized versions
  *
  * Reference: Uddin et al. (2022) - Classic k-NN variant
+ *
+ * Out-of-core mode (fitStream): the training set stays in a CSV file and
+ * every search streams it in chunks (CSVChunkReader), keeping a top-k set
+ * per query across chunks. Batches share one pass over the file.
  */
 class KNNBasic {
 private:
-    std::vector<Point> trainingData;
+    Dataset trainingData;
     int k;
     DistanceType distanceMetric;
     double minkowskiP;  // Parameter for Minkowski distance
+    Precision precision;
+    AlignedVector<float> floatRows;  // float32 copy of the rows scanned by searches
+
+    static constexpr size_t BLOCK_ROWS = 256;  // training rows per distance kernel call
+
+    // Out-of-core training set (streamPath empty when data is in memory)
+    std::string streamPath;
+    size_t streamChunkRows;
+    bool streamHeader;
+    int streamLabelColumn;
+    size_t streamDims;
+
+    // A candidate of a batch search: training row index and its label
+    struct Candidate {
+        int index;
+        int label;
+    };
+    using CandidateSet = KNearestSet<Candidate>;
 
-    double calculateDistance(const Point& a, const Point& b) const;
+    int majorityVote(const std::vector<Neighbor>& neighbors) const;
+    static int majorityVote(const std::vector<int>& labels);
+    size_t trainingDimensions() const;
+    // Folds the rows of chunk, numbered from firstIndex, into the candidate
+    // set of every query; chunkFloats / queryFloats are the float32 copies
+    // used by FLOAT32 and MIXED precision
+    void scanChunk(const Dataset& chunk, const float* chunkFloats, size_t firstIndex,
+                   const Dataset& queries, const float* queryFloats,
+                   std::vector<CandidateSet>& nearest, int numThreads) const;
+    // k nearest of every query (reduced distances), from memory or the stream;
+    // rows counts the training rows scanned
+    std::vector<CandidateSet> searchBatch(const Dataset& queries, int numThreads,
+                                          size_t& rows) const;
 
 public:
-    KNNBasic(int k_neighbors, DistanceType metric = DistanceType::EUCLIDEAN, double p = 2.0);
+    // precision: FLOAT32 and MIXED scan a float32 copy of the training rows
+    KNNBasic(int k_neighbors, DistanceType metric = DistanceType::EUCLIDEAN, double p = 2.0,
+             Precision precision = Precision::FLOAT64);
 
     void fit(const std::vector<Point>& data);
+    void fit(const Dataset& data);
+
+    // Out-of-core mode: searches read the numeric CSV file at filepath
+    // (parsed as by DatasetLoader::loadCSVDataset) chunkRows rows at a time
+    // instead of fitted data; the file must not change while in use. Neighbor
+    // indices are row numbers in the file's data rows. findKNearest() needs
+    // in-memory data.
+    void fitStream(const std::string& filepath,
+                   size_t chunkRows = CSVChunkReader::DEFAULT_CHUNK_ROWS,
+                   bool hasHeader = true, int labelColumn = -1);
+    bool isStreaming() const { return !streamPath.empty(); }
     std::vector<Point> findKNearest(const Point& query);
-    int predict(const Point& query);  // For classification
+    int predict(RowView query);  // For classification
+
+    // k nearest as (training index, distance) pairs, nearest first
+    std::vector<Neighbor> findKNearestIndices(RowView query);
+    const Dataset& getTrainingData() const { return trainingData; }
+
+    // Batched queries: every chunk of training rows is scanned once for the
+    // whole batch while it is in cache (one pass over the file in
+    // out-of-core mode); queries are split across numThreads workers
+    // (<= 0: one per core). Result i belongs to queries[i].
+    std::vector<std::vector<Neighbor>> findKNearestIndicesBatch(const Dataset& queries,
+                                                                int numThreads = 0);
+    std::vector<int> predictBatch(const Dataset& queries, int numThreads = 0);
 
     // New: Single instance prediction with metrics
     struct PredictionResult {
@@ -34,7 +100,7 @@ public:
         double prediction_time_ms;
     };
 
-    PredictionResult predictWithMetrics(const Point& query);
+    PredictionResult predictWithMetrics(RowView query);
 };
 
 #endif // KNN_BASIC_H
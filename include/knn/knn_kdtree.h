@@ -1,10 +1,14 @@
 #ifndef KNN_KDTREE_H
 #define KNN_KDTREE_H
 
+#include <memory>
+#include <string>
 #include <vector>
 #include "../kdtree/kdtree.h"
 #include "../utils/point.h"
+#include "../utils/dataset.h"
 #include "../utils/distance_metrics.h"
+#include "../utils/neighbor.h"
 
 /**
  * k-NN implementation using k-d tree optimization
@@ -15,19 +19,58 @@
 class KNNKDTree {
 private:
     KDTree* tree;
-    std::vector<Point> trainingData;
+    Dataset trainingData;
     int k;
     int dimensions;
     DistanceType distanceMetric;
     double minkowskiP;
+    int leafSize;
+
+    int majorityVote(const std::vector<Neighbor>& neighbors) const;
+    // Throws unless the model is fitted and query has its dimension
+    void checkQuery(size_t queryDims) const;
 
 public:
-    KNNKDTree(int k_neighbors, int dims, DistanceType metric = DistanceType::EUCLIDEAN, double p = 2.0);
+    // leafSize: maximum number of points per leaf bucket of the k-d tree
+    // precision: coordinate storage of the k-d tree index
+    // splitRule: split choice of the k-d tree build
+    KNNKDTree(int k_neighbors, int dims, DistanceType metric = DistanceType::EUCLIDEAN, double p = 2.0,
+              int leafSize = KDTree::DEFAULT_LEAF_SIZE, Precision precision = Precision::FLOAT64,
+              SplitRule splitRule = SplitRule::CYCLIC);
     ~KNNKDTree();
 
-    void fit(const std::vector<Point>& data);
+    // The index is built on numThreads workers (<= 0: one per core)
+    void fit(const std::vector<Point>& data, int numThreads = 0);
+    void fit(const Dataset& data, int numThreads = 0);
     std::vector<Point> findKNearest(const Point& query);
-    int predict(const Point& query);  // For classification
+    int predict(RowView query);  // For classification
+
+    // k nearest as (training index, distance) pairs, nearest first; the
+    // index refers to the data passed to fit()
+    std::vector<Neighbor> findKNearestIndices(RowView query);
+    // Empty for a model opened with load()
+    const Dataset& getTrainingData() const { return trainingData; }
+    int getDimensions() const { return dimensions; }
+    DistanceType getDistanceMetric() const { return distanceMetric; }
+    double getMinkowskiP() const { return minkowskiP; }
+    int getLeafSize() const { return leafSize; }
+
+    // Saves the fitted k-d tree index (see KDTree::save); load() reopens it
+    // memory-mapped, with the saved metric and tree configuration, ready to
+    // predict without refitting
+    void save(const std::string& path) const;
+    static std::unique_ptr<KNNKDTree> load(const std::string& path, int k_neighbors);
+
+    // Batched queries split across numThreads workers (<= 0: one per core);
+    // result i belongs to queries[i]
+    std::vector<std::vector<Point>> findKNearestBatch(const std::vector<Point>& queries,
+                                                      int numThreads = 0);
+    std::vector<std::vector<Neighbor>> findKNearestIndicesBatch(const std::vector<Point>& queries,
+                                                                int numThreads = 0);
+    std::vector<std::vector<Neighbor>> findKNearestIndicesBatch(const Dataset& queries,
+                                                                int numThreads = 0);
+    std::vector<int> predictBatch(const std::vector<Point>& queries, int numThreads = 0);
+    std::vector<int> predictBatch(const Dataset& queries, int numThreads = 0);
 
     // New: Single instance prediction with metrics
     struct PredictionResult {
@@ -36,11 +79,27 @@ public:
         double prediction_time_ms;
     };
 
-    PredictionResult predictWithMetrics(const Point& query);
+    PredictionResult predictWithMetrics(RowView query);
+
+    // Leave-one-out prediction: the training point with input index
+    // excludeIndex (e.g. the query's own row) does not vote. k + 1
+    // neighbors are searched and that point, or else the farthest, dropped.
+    PredictionResult predictWithMetrics(RowView query, int excludeIndex);
+
+    // Training point with the given input index, read from the index (also
+    // after load()); false if it is not indexed (see KDTree::pointOf)
+    bool trainingPoint(int index, Point& point) const { return tree->pointOf(index, point); }
+
+    // Training inputs dropped as duplicates of that point (KDTree::duplicatesOf)
+    int trainingDuplicates(int index) const { return tree->duplicatesOf(index); }
 
     // Distance calculation counter methods
     void resetDistanceCount();
-    int getDistanceCount() const;
+    long long getDistanceCount() const;
+
+    // k-d tree nodes visited by queries
+    void resetNodeVisitCount();
+    long long getNodeVisitCount() const;
 };
 
 #endif // KNN_KDTREE_H
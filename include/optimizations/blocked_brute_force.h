@@ -0,0 +1,65 @@
+#ifndef BLOCKED_BRUTE_FORCE_H
+#define BLOCKED_BRUTE_FORCE_H
+
+#include <atomic>
+#include <vector>
+#include "../utils/point.h"
+#include "../utils/dataset.h"
+#include "../utils/neighbor.h"
+#include "../utils/aligned_allocator.h"
+
+/**
+ * Exact brute-force k-NN for query batches, organized like a matrix product
+ * Squared Euclidean distances are expanded as ||q||^2 + ||x||^2 - 2 q.x, so
+ * the bulk of the work is the query x train dot-product matrix:
+ * - training rows are stored in tiles of tileRows rows, each tile transposed
+ *   (axis-major)
+ * - the product is computed in register micro-tiles of 4 queries x 8 rows
+ *   (16 with AVX-512) by DistanceKernels::dotProducts: partial sums stay in
+ *   registers over all axes and each loaded tile value serves 4 queries
+ * - a tile is sized to stay in L1/L2 and is reused by every query of a
+ *   QUERY_TILE block before moving on
+ * - each query keeps a bounded top-k set, so no distance matrix is stored
+ * Query blocks are spread over a worker pool.
+ *
+ * Meant for high-dimensional data, where k-d trees visit most leaves anyway.
+ * Euclidean metric only; the expansion loses a little precision compared to
+ * summing squared differences, which only matters for near-ties.
+ */
+class BlockedBruteForce {
+private:
+    int dims;
+    size_t tileRows;                    // training rows per tile
+    Dataset trainingData;
+    AlignedVector<double> tiles;        // tile t, axis d, row j at ((t * dims) + d) * tileRows + j
+    AlignedVector<double> norms;        // ||x||^2 per training row
+    mutable std::atomic<long long> distance_calc_count;
+
+    const double* tileColumn(size_t t, int d) const {
+        return tiles.data() + (t * dims + d) * tileRows;
+    }
+
+public:
+    static constexpr size_t QUERY_TILE = 32;   // queries sharing each training tile
+
+    explicit BlockedBruteForce(int dimensions);
+
+    void fit(const std::vector<Point>& data);
+    void fit(const Dataset& data);
+
+    // k nearest training rows of every query (index into the fitted data,
+    // Euclidean distance), nearest first; numThreads <= 0: one per core
+    std::vector<std::vector<Neighbor>> kNearestNeighborsBatch(const Dataset& queries, int k,
+                                                              int numThreads = 0) const;
+    std::vector<std::vector<Neighbor>> kNearestNeighborsBatch(const std::vector<Point>& queries, int k,
+                                                              int numThreads = 0) const;
+
+    size_t size() const { return trainingData.size(); }
+    size_t getTileRows() const { return tileRows; }
+    const Dataset& getTrainingData() const { return trainingData; }
+
+    void resetDistanceCount() { distance_calc_count = 0; }
+    long long getDistanceCount() const { return distance_calc_count; }
+};
+
+#endif // BLOCKED_BRUTE_FORCE_H
@@ -1,6 +1,11 @@
 #ifndef QUICKNN_H
 #define QUICKNN_H
 
+#include <vector>
+#include "../utils/point.h"
+#include "../utils/aligned_allocator.h"
+#include "../utils/knearest_set.h"
+
 /**
  * QuickNN optimizations for k-d tree based nearest neighbor search
  * Based on: Pinkham, R., Zeng, S., Zhang, Z. (2020)
@@ -9,14 +14,75 @@
  *
  * Key optimizations:
  * - Memory layout optimization
- * - Cache-friendly data structures
- * - Early termination strategies
- * - Vectorization opportunities
+ *   Nodes are 16-byte records in a cache-line-aligned array (four per line,
+ *   none straddling a line). Leaf buckets are contiguous row-major blocks.
+ * - Query batching
+ *   Queries are routed to the bucket they land in and grouped by it, so each
+ *   bucket is streamed once for all of its queries. Grouped queries are then
+ *   finished in bucket order: spatially close queries run back to back and
+ *   find the nodes and neighboring buckets they need still in cache.
+ * - Early termination
+ *   Every bucket keeps its tight bounding box; a bucket is only streamed if
+ *   the box is closer than the query's current k-th neighbor.
+ *
+ * Squared Euclidean distance, tuned for low-dimensional (3D) point clouds.
  */
-
-// Placeholder for future implementation
 class QuickNN {
-    // QuickNN optimizations
+private:
+    // Compact node record; the left subtree of node i is at i + 1
+    struct alignas(16) Node {
+        double split;   // discriminating key value
+        int disc;       // discriminator, -1 for leaves
+        int next;       // right subtree for inner nodes, bucket for leaves
+    };
+    static_assert(sizeof(Node) == 16, "QuickNN node must stay 16 bytes");
+
+    int k;                              // number of dimensions
+    int leafSize;
+
+    AlignedVector<Node> nodes;
+    AlignedVector<double> points;       // row-major, bucket after bucket
+    std::vector<int> labels;
+    std::vector<int> bucketOffsets;     // bucket b holds rows [offsets[b], offsets[b + 1])
+    std::vector<double> bucketLower;    // tight bounding box of bucket b: [b * k, (b + 1) * k)
+    std::vector<double> bucketUpper;
+
+    mutable long long distance_calc_count;
+
+    const double* row(int i) const { return points.data() + static_cast<size_t>(i) * k; }
+    int buildRec(std::vector<int>& order, const std::vector<Point>& data, int begin, int end);
+    Point pointAt(int i) const;
+
+    int homeBucket(const double* q) const;
+    double bucketLowerBound(int bucket, const double* q) const;
+    void scanBucket(int bucket, const double* q, KNearestSet<int>& candidates) const;
+
+    // Depth-first search over all buckets but home, with incremental cell bounds
+    void kNearestRec(int node, const double* q, double rd, std::vector<double>& offsets,
+                     int home, KNearestSet<int>& candidates) const;
+
+public:
+    static constexpr int DEFAULT_LEAF_SIZE = 32;
+
+    QuickNN(int dimensions = 3, int leafSize = DEFAULT_LEAF_SIZE);
+
+    void fit(const std::vector<Point>& data);
+    size_t size() const { return labels.size(); }
+    size_t bucketCount() const { return bucketOffsets.empty() ? 0 : bucketOffsets.size() - 1; }
+
+    // Nearest neighbor search
+    Point nearestNeighbor(const Point& target) const;
+
+    // k-NN search - find k nearest neighbors (ascending distance)
+    std::vector<Point> kNearestNeighbors(const Point& target, int k) const;
+
+    // Batched k-NN search; result i belongs to queries[i]
+    std::vector<std::vector<Point>> kNearestNeighborsBatch(const std::vector<Point>& queries,
+                                                           int k) const;
+
+    // Get distance calculations count (for metrics)
+    void resetDistanceCount() { distance_calc_count = 0; }
+    long long getDistanceCount() const { return distance_calc_count; }
 };
 
 #endif // QUICKNN_H
@@ -1,6 +1,11 @@
 #ifndef REVISED_KDTREE_H
 #define REVISED_KDTREE_H
 
+#include <vector>
+#include "../utils/point.h"
+#include "../utils/distance_metrics.h"
+#include "../utils/knearest_set.h"
+
 /**
  * Revised k-d tree for fast neighbor search
  * Based on: Jiang, K., et al. (2018)
@@ -8,13 +13,79 @@
  *
  * Key techniques:
  * - Reducing unnecessary distance calculations
+ *   Every node keeps the tight bounding box of its points. A node whose box
+ *   is outside the query neighborhood is skipped; in a range query a node
+ *   whose box is inside the neighborhood is reported without computing any
+ *   distance. Inside a leaf, each point's distance to the leaf pivot is
+ *   precomputed and the triangle inequality discards points that cannot
+ *   beat the current k-th neighbor.
  * - Eliminating redundant node visits
- * - Improved pruning strategies
+ *   Every node saves the (contiguous) indices of its descendant points, so a
+ *   subtree that is wholly inside the neighborhood is never traversed.
+ *   Children are visited nearest box first.
  */
-
-// Placeholder for future implementation
 class RevisedKDTree {
-    // Revised k-d tree implementation
+private:
+    // Node of the index; the left subtree of node i is at i + 1
+    struct Node {
+        double split;   // discriminating key value
+        int disc;       // discriminator, -1 for leaves
+        int hison;      // index of right subtree
+        int begin;      // descendant points [begin, end)
+        int end;
+    };
+
+    int k;                          // number of dimensions
+    DistanceType distanceMetric;
+    double minkowskiP;
+    int leafSize;
+    bool useTriangleInequality;     // only valid for true metrics
+
+    std::vector<Node> nodes;
+    std::vector<double> lower;      // bounding box of node i: [i * k, (i + 1) * k)
+    std::vector<double> upper;
+    std::vector<double> points;     // row-major, in tree order
+    std::vector<int> labels;
+    std::vector<int> pivotOf;       // leaf node -> pivot row in pivots
+    std::vector<double> pivots;     // row-major leaf pivots (bucket centroids)
+    std::vector<double> pivotDistance;  // real distance of point i to its leaf pivot
+
+    mutable long long distance_calc_count;
+
+    const double* row(int i) const { return points.data() + static_cast<size_t>(i) * k; }
+    int buildRec(std::vector<int>& order, const std::vector<Point>& data,
+                 int begin, int end);
+    void buildLeaf(int node);
+
+    double reduced(const Point& target, const double* x) const;
+    double boxLowerBound(int node, const Point& target) const;
+    double boxUpperBound(int node, const Point& target) const;
+    Point pointAt(int i) const;
+
+    void kNearestRec(int node, const Point& target, double lowerBound,
+                     KNearestSet<int>& candidates) const;
+    void rangeRec(int node, const Point& target, double reducedRadius,
+                  std::vector<int>& result) const;
+
+public:
+    RevisedKDTree(int dimensions, DistanceType metric = DistanceType::EUCLIDEAN,
+                  double p = 2.0, int leafSize = 10);
+
+    void fit(const std::vector<Point>& data);
+    size_t size() const { return labels.size(); }
+
+    // Nearest neighbor search
+    Point nearestNeighbor(const Point& target) const;
+
+    // k-NN search - find k nearest neighbors (ascending distance)
+    std::vector<Point> kNearestNeighbors(const Point& target, int k) const;
+
+    // Range search - all points within radius of target
+    std::vector<Point> rangeSearch(const Point& target, double radius) const;
+
+    // Get distance calculations count (for metrics)
+    void resetDistanceCount() { distance_calc_count = 0; }
+    long long getDistanceCount() const { return distance_calc_count; }
 };
 
 #endif // REVISED_KDTREE_H
@@ -0,0 +1,32 @@
+#ifndef ARRAY_VIEW_H
+#define ARRAY_VIEW_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Read-only view of a contiguous array owned elsewhere
+ * Lets search code read an index the same way whether its arrays live in
+ * vectors (after a build) or in a memory-mapped file (after a load).
+ */
+template <typename T>
+class ArrayView {
+private:
+    const T* ptr = nullptr;
+    size_t count = 0;
+
+public:
+    ArrayView() = default;
+    ArrayView(const T* data, size_t size) : ptr(data), count(size) {}
+    template <typename Alloc>
+    ArrayView(const std::vector<T, Alloc>& values) : ptr(values.data()), count(values.size()) {}
+
+    const T& operator[](size_t i) const { return ptr[i]; }
+    const T* data() const { return ptr; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+};
+
+#endif // ARRAY_VIEW_H
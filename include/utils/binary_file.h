@@ -0,0 +1,69 @@
+#ifndef BINARY_FILE_H
+#define BINARY_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+/**
+ * Shared layout of the repository's binary files (k-d tree indexes,
+ * dataset caches)
+ * A file starts with a fixed header whose first fields are a Preamble
+ * (magic, version, byte order), followed by sections the header points to.
+ * Sections start on SECTION_ALIGNMENT boundaries so arrays read through a
+ * memory mapping are as aligned as heap ones. Files are in native byte
+ * order; a file from another platform fails checkPreamble().
+ */
+namespace BinaryFile {
+
+constexpr uint64_t SECTION_ALIGNMENT = 64;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;  // reads differently in the other byte order
+
+struct Preamble {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;     // BYTE_ORDER_MARK as written
+};
+static_assert(sizeof(Preamble) == 16, "Preamble is part of the on-disk layout");
+
+enum class PreambleCheck {
+    OK,
+    WRONG_MAGIC,            // not a file of this format
+    WRONG_VERSION,
+    WRONG_BYTE_ORDER
+};
+
+Preamble makePreamble(const char (&magic)[8], uint32_t version);
+PreambleCheck checkPreamble(const Preamble& preamble, const char (&magic)[8], uint32_t version);
+
+uint64_t alignedOffset(uint64_t offset, uint64_t alignment = SECTION_ALIGNMENT);
+
+/**
+ * Writes a header followed by sections
+ * Space for the header is reserved on open and the header goes in last
+ * (finish()), once the section offsets it records are known.
+ */
+class SectionWriter {
+private:
+    std::ofstream out;
+    uint64_t pos;
+
+public:
+    SectionWriter(const std::string& path, size_t headerBytes);
+
+    bool isOpen() const { return out.is_open(); }
+    uint64_t size() const { return pos; }   // bytes written so far
+
+    // Writes bytes at the next offset aligned to alignment (at most
+    // SECTION_ALIGNMENT); returns that offset
+    uint64_t write(const void* data, uint64_t bytes, uint64_t alignment = SECTION_ALIGNMENT);
+
+    // Writes the header at offset 0 and closes the file; returns false if
+    // any write failed
+    bool finish(const void* header, size_t headerBytes);
+};
+
+} // namespace BinaryFile
+
+#endif // BINARY_FILE_H
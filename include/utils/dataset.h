@@ -0,0 +1,83 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include <cstddef>
+#include <vector>
+#include "point.h"
+#include "aligned_allocator.h"
+
+/**
+ * Read-only view of one sample: a pointer to dims contiguous coordinates
+ * plus the label. Points convert implicitly, so APIs taking a RowView accept
+ * both Dataset rows and Points without copying.
+ */
+struct RowView {
+    const double* data;
+    size_t dims;
+    int label;
+
+    RowView() : data(nullptr), dims(0), label(-1) {}
+    RowView(const double* values, size_t dims, int lbl = -1)
+        : data(values), dims(dims), label(lbl) {}
+    RowView(const Point& p)
+        : data(p.coordinates.data()), dims(p.coordinates.size()), label(p.label) {}
+
+    size_t dimensions() const { return dims; }
+    const double& operator[](size_t i) const { return data[i]; }
+
+    Point toPoint() const { return Point(std::vector<double>(data, data + dims), label); }
+};
+
+/**
+ * Dense sample matrix: all coordinates in one row-major buffer (row i starts
+ * at i * dimensions()) and the labels in a parallel array. An optional
+ * column-major copy serves per-axis scans such as k-d tree partitioning.
+ *
+ * Replaces std::vector<Point> for large data: one allocation instead of one
+ * per sample, and rows are cache-line aligned for vectorized kernels.
+ */
+class Dataset {
+private:
+    size_t rows;
+    size_t dims;
+    AlignedVector<double> values;     // row-major, rows * dims
+    std::vector<int> rowLabels;
+    AlignedVector<double> columnValues;  // column-major copy, empty unless built
+
+public:
+    Dataset() : rows(0), dims(0) {}
+    explicit Dataset(size_t dimensions) : rows(0), dims(dimensions) {}
+    Dataset(size_t numRows, size_t dimensions);  // Zero-filled, labels -1
+
+    // Conversions from/to the per-point representation
+    static Dataset fromPoints(const std::vector<Point>& points);
+    std::vector<Point> toPoints() const;
+
+    size_t size() const { return rows; }
+    size_t dimensions() const { return dims; }
+    bool empty() const { return rows == 0; }
+
+    void reserve(size_t numRows);
+    void resize(size_t numRows);  // New rows are zero with label -1
+    void addRow(const double* coords, int label = -1);
+    void addRow(const Point& point);  // Throws if the dimension does not match
+
+    RowView row(size_t i) const { return RowView(rowData(i), dims, rowLabels[i]); }
+    RowView operator[](size_t i) const { return row(i); }
+    const double* rowData(size_t i) const { return values.data() + i * dims; }
+    double* rowData(size_t i) { return values.data() + i * dims; }
+
+    int label(size_t i) const { return rowLabels[i]; }
+    void setLabel(size_t i, int label) { rowLabels[i] = label; }
+
+    const double* data() const { return values.data(); }
+    const std::vector<int>& labels() const { return rowLabels; }
+
+    // Column-major copy (axis d of row i at column(d)[i]); must be rebuilt
+    // after rows are added or changed
+    void buildColumnMajor();
+    bool hasColumnMajor() const { return !columnValues.empty() || rows == 0; }
+    const double* column(size_t d) const { return columnValues.data() + d * rows; }
+};
+
+#endif // DATASET_H
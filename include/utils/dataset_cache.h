@@ -0,0 +1,68 @@
+#ifndef DATASET_CACHE_H
+#define DATASET_CACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "dataset.h"
+
+/**
+ * Binary columnar cache of a parsed dataset
+ * Text parsing dominates loading for large CSV files, so a loader can save
+ * its result once and read it back on later runs. The cache file holds the
+ * labels and one contiguous column of doubles per feature, plus:
+ * - a key describing the loader and its options (a cache written for other
+ *   options is ignored)
+ * - the source file's size, modification time and checksum (a cache of an
+ *   edited file is ignored)
+ * - the categorical encoding that produced the features
+ * A cache hit does not read the source: by default only its size and
+ * modification time are compared (a stat call). The full checksum is
+ * compared only when asked for, e.g. for files rewritten in place within
+ * the file system's timestamp resolution.
+ * The cache is read through a memory mapping; load() copies the mapped
+ * columns into the row-major Dataset in one pass (no parsing), since a
+ * Dataset owns its rows. Files are in native byte order; a cache from
+ * another platform is simply not used.
+ */
+class DatasetCache {
+public:
+    // How text columns were turned into numbers
+    struct Encoding {
+        std::vector<int> columns;                          // one-hot encoded source columns
+        std::vector<std::vector<std::string>> categories;  // categories of columns[i], in one-hot order
+        std::vector<std::string> labelCategories;          // text labels, coded 0, 1, ... in this order
+    };
+
+    // Identity of a source file; checksum is 0 when not computed
+    struct Source {
+        uint64_t size;
+        int64_t modified;   // modification time, in file clock ticks
+        uint64_t checksum;
+    };
+
+    // Checksum of a file's contents (64-bit FNV-1a over 8-byte words, mixed
+    // with the length); throws std::runtime_error if the file cannot be read
+    static uint64_t checksum(const std::string& path);
+
+    // Size and modification time of a file, plus its checksum if
+    // withChecksum (a full read); throws std::runtime_error if the file
+    // cannot be read
+    static Source source(const std::string& path, bool withChecksum = false);
+
+    // Cache file used for a source file when no path is given
+    static std::string defaultPath(const std::string& sourcePath) { return sourcePath + ".cache"; }
+
+    // Reads cachePath into data (and encoding) if it exists, is intact and was
+    // saved with the same key for a source of the same size and modification
+    // time (and checksum, if source has one); returns false otherwise
+    static bool load(const std::string& cachePath, const std::string& key, const Source& source,
+                     Dataset& data, Encoding* encoding = nullptr);
+
+    // Writes data to cachePath; returns false if the file cannot be written.
+    // Loads that verify checksums skip a cache saved without one.
+    static bool save(const std::string& cachePath, const std::string& key, const Source& source,
+                     const Dataset& data, const Encoding& encoding = Encoding());
+};
+
+#endif // DATASET_CACHE_H
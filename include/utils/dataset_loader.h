@@ -4,11 +4,18 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <fstream>
 #include "point.h"
+#include "dataset.h"
+#include "dataset_cache.h"
 
 /**
  * Dataset loading utilities
  * Supports various formats for benchmark datasets
+ *
+ * Numeric CSV files are memory-mapped and parsed in place: cells are
+ * scanned with std::from_chars (no per-cell strings), and the file is cut
+ * into newline-aligned chunks parsed by a worker pool.
  */
 class DatasetLoader {
 public:
@@ -18,6 +25,13 @@ public:
                                       bool hasHeader = true,
                                       int labelColumn = -1);
 
+    // Same as loadCSV, parsed straight into one contiguous Dataset on
+    // numThreads workers (<= 0: one per core)
+    static Dataset loadCSVDataset(const std::string& filepath,
+                                  bool hasHeader = true,
+                                  int labelColumn = -1,
+                                  int numThreads = 0);
+
     // Load CSV with automatic one-hot encoding for categorical columns
     // categoricalColumns: indices of columns to one-hot encode (empty = auto-detect)
     // labelColumn: index of the column containing the label (-1 means last column)
@@ -26,6 +40,21 @@ public:
                                                    const std::vector<int>& categoricalColumns = {},
                                                    int labelColumn = -1);
 
+    // loadCSVDataset (or, with encode, loadCSVWithEncoding with auto-detected
+    // categorical columns) through a binary cache at cachePath (default:
+    // DatasetCache::defaultPath). The first load parses the CSV and writes
+    // the cache; later loads with the same options read the cache instead
+    // while the CSV is unchanged (same size and modification time, and with
+    // verifyChecksum the same contents, which costs a read of the CSV).
+    // encoding receives the one-hot encoding that produced the features.
+    static Dataset loadCSVCached(const std::string& filepath,
+                                 bool hasHeader = true,
+                                 int labelColumn = -1,
+                                 bool encode = false,
+                                 const std::string& cachePath = "",
+                                 DatasetCache::Encoding* encoding = nullptr,
+                                 bool verifyChecksum = false);
+
     // Generate synthetic datasets for testing
     static std::vector<Point> generateRandom(int numPoints, int dimensions, int seed = 42);
     static std::vector<Point> generateClustered(int numClusters, int pointsPerCluster,
@@ -39,6 +68,13 @@ public:
                                int seed = 42);
 
 private:
+    // loadCSVWithEncoding, also reporting the encoding it used
+    static std::vector<Point> loadCSVEncoded(const std::string& filepath,
+                                             bool hasHeader,
+                                             const std::vector<int>& categoricalColumns,
+                                             int labelColumn,
+                                             DatasetCache::Encoding* encoding);
+
     // Helper: Check if string is numeric
     static bool isNumeric(const std::string& str);
 
@@ -48,4 +84,40 @@ private:
                                                       int labelColumn = -1);
 };
 
+/**
+ * Streaming reader of numeric CSV files, for data larger than memory
+ * Yields the rows loadCSVDataset would load, in file order, in chunks of at
+ * most chunkRows rows, so memory stays proportional to the chunk size. The
+ * first row fixes the dimensionality; ragged rows are skipped.
+ */
+class CSVChunkReader {
+private:
+    std::ifstream file;
+    std::string filepath;
+    size_t chunkRows;
+    bool hasHeader;
+    int labelColumn;
+    size_t dims;        // 0 until the first row is read
+    size_t rowsRead;    // rows yielded so far
+    std::string line;
+    std::vector<double> allValues;
+    std::vector<double> coords;
+
+public:
+    static constexpr size_t DEFAULT_CHUNK_ROWS = 1 << 16;
+
+    // Throws std::runtime_error if the file cannot be opened
+    CSVChunkReader(const std::string& filepath, size_t chunkRows = DEFAULT_CHUNK_ROWS,
+                   bool hasHeader = true, int labelColumn = -1);
+
+    // Replaces chunk's rows with the next chunk (chunk keeps its capacity);
+    // returns false once the file is exhausted
+    bool next(Dataset& chunk);
+    void rewind();      // Back to the first row
+
+    size_t dimensions() const { return dims; }
+    size_t position() const { return rowsRead; }  // index of the next chunk's first row
+    size_t getChunkRows() const { return chunkRows; }
+};
+
 #endif // DATASET_LOADER_H
@@ -0,0 +1,43 @@
+#ifndef DIMENSIONS_H
+#define DIMENSIONS_H
+
+#include <type_traits>
+
+/**
+ * Compile-time dimensionality
+ * Hot loops can be instantiated for a fixed number of axes D, so per-axis
+ * loops fully unroll and per-query scratch fits in fixed-size arrays.
+ * DYNAMIC (-1, as in nanoflann) keeps the dimension a runtime value.
+ * withDimensions() is the dispatch helper: it maps a runtime dimension to
+ * the matching specialization for common values and calls fn with it.
+ */
+namespace Dimensions {
+
+constexpr int DYNAMIC = -1;
+
+template <int D>
+using Fixed = std::integral_constant<int, D>;
+
+// Number of axes of a D specialization; runtime is used for DYNAMIC
+template <int D>
+constexpr int count(int runtime) {
+    return D == DYNAMIC ? runtime : D;
+}
+
+// Calls fn(Fixed<D>{}) for the specialized dimensions, Fixed<DYNAMIC>
+// otherwise, and returns its result
+template <class Fn>
+decltype(auto) withDimensions(int dims, Fn&& fn) {
+    switch (dims) {
+        case 2: return fn(Fixed<2>{});
+        case 3: return fn(Fixed<3>{});
+        case 4: return fn(Fixed<4>{});
+        case 8: return fn(Fixed<8>{});
+        case 16: return fn(Fixed<16>{});
+        default: return fn(Fixed<DYNAMIC>{});
+    }
+}
+
+} // namespace Dimensions
+
+#endif // DIMENSIONS_H
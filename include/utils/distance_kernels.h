@@ -0,0 +1,80 @@
+#ifndef DISTANCE_KERNELS_H
+#define DISTANCE_KERNELS_H
+
+#include <cstddef>
+
+/**
+ * Vectorized distance kernels with runtime CPU dispatch
+ * Each kernel has AVX-512, AVX2 (+FMA), SSE2 and scalar versions; the widest
+ * one the CPU supports is picked once, on first use, via CPUID. Builds for
+ * other architectures (or compilers without x86 target attributes) only get
+ * the scalar versions.
+ *
+ * Row kernels compare two contiguous vectors; one-to-many kernels compare a
+ * query against a block of row-major rows in one call. Column kernels serve
+ * structure-of-arrays scans (k-d tree leaf buckets): they fold one axis of n
+ * points into n running per-point distances.
+ */
+namespace DistanceKernels {
+
+enum class Isa { SCALAR, SSE2, AVX2, AVX512 };
+
+Isa detectedIsa();              // Best instruction set of this CPU
+Isa activeIsa();                // Instruction set the kernels currently use
+const char* isaName(Isa isa);
+
+// Switches every kernel to isa (for benchmarks and tests). Returns false,
+// leaving the kernels unchanged, if the CPU does not support it. Not safe to
+// call while other threads compute distances.
+bool setIsa(Isa isa);
+
+// Row kernels
+double squaredEuclidean(const double* a, const double* b, size_t n);
+double manhattan(const double* a, const double* b, size_t n);
+double chebyshev(const double* a, const double* b, size_t n);
+
+float squaredEuclidean(const float* a, const float* b, size_t n);
+float manhattan(const float* a, const float* b, size_t n);
+float chebyshev(const float* a, const float* b, size_t n);
+
+// One-to-many kernels: out[r] = distance(query, rows + r * dims) for r in
+// [0, count)
+void squaredEuclideanMany(const double* query, const double* rows, size_t count, size_t dims,
+                          double* out);
+void manhattanMany(const double* query, const double* rows, size_t count, size_t dims,
+                   double* out);
+void chebyshevMany(const double* query, const double* rows, size_t count, size_t dims,
+                   double* out);
+
+void squaredEuclideanMany(const float* query, const float* rows, size_t count, size_t dims,
+                          float* out);
+void manhattanMany(const float* query, const float* rows, size_t count, size_t dims,
+                   float* out);
+void chebyshevMany(const float* query, const float* rows, size_t count, size_t dims,
+                   float* out);
+
+// Column kernels: out[i] += (x[i] - q)^2, out[i] += |x[i] - q| and
+// out[i] = max(out[i], |x[i] - q|) for i in [0, n)
+void accumulateSquared(const double* x, double q, double* out, size_t n);
+void accumulateAbs(const double* x, double q, double* out, size_t n);
+void accumulateMaxAbs(const double* x, double q, double* out, size_t n);
+
+void accumulateSquared(const float* x, float q, float* out, size_t n);
+void accumulateAbs(const float* x, float q, float* out, size_t n);
+void accumulateMaxAbs(const float* x, float q, float* out, size_t n);
+
+// out[i] += s * x[i] for i in [0, n) (the inner step of blocked dot products)
+void accumulateScaled(const double* x, double s, double* out, size_t n);
+void accumulateScaled(const float* x, float s, float* out, size_t n);
+
+// Micro-kernel of a blocked matrix product: out[i * n + j] = sum over d of
+// queries[i][d] * x[d * stride + j] for the DOT_QUERIES queries i and
+// j in [0, n), x being axis-major. Partial sums stay in registers for all
+// axes, so each loaded value of x is used by every query.
+constexpr size_t DOT_QUERIES = 4;
+void dotProducts(const double* const* queries, const double* x, size_t stride, size_t dims,
+                 double* out, size_t n);
+
+} // namespace DistanceKernels
+
+#endif // DISTANCE_KERNELS_H
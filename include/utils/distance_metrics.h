@@ -10,6 +10,15 @@
  * Reference: Uddin et al. (2022) discusses different distance measures
  */
 
+// Distance metric types
+enum class DistanceType {
+    EUCLIDEAN,
+    MANHATTAN,
+    HAMMING,
+    MINKOWSKI,
+    CHEBYSHEV
+};
+
 namespace DistanceMetrics {
     // Global counter for distance calculations (thread-safe)
     extern std::atomic<long long> distance_calculation_counter;
@@ -33,14 +42,33 @@ namespace DistanceMetrics {
 
     // Hamming distance (for discrete/binary features)
     double hamming(const Point& a, const Point& b);
-}
 
-// Distance metric types
-enum class DistanceType {
-    EUCLIDEAN,
-    MANHATTAN,
-    HAMMING,
-    MINKOWSKI
-};
+    // Reduced distance: a monotone transform of the distance that is cheaper
+    // to compute and orders points the same way (squared L2, sum of p-th
+    // powers for Minkowski, the distance itself for L1, L-infinity and Hamming)
+    // These runtime entry points resolve the metric to its policy (see
+    // metric_policies.h) on every call; search loops use the policies directly
+    double reducedDistance(const Point& a, const Point& b, DistanceType type, double p = 2.0);
+    double reducedDistance(const double* a, const double* b, size_t dims,
+                           DistanceType type, double p = 2.0);
+
+    // Reduced distances from query to count contiguous rows of dims values
+    // (out[r] for the row at rows + r * dims); the metric is resolved once
+    // for the whole block
+    void reducedDistances(const double* query, const double* rows, size_t count, size_t dims,
+                          DistanceType type, double p, double* out);
+
+    // Lower bound on the reduced distance to any point whose coordinate on one
+    // axis differs from the query by at least |diff| (used for pruning)
+    double reducedAxisDistance(double diff, DistanceType type, double p = 2.0);
+
+    // Adds one axis bound to a lower bound built from several axes (a sum,
+    // or the maximum for Chebyshev)
+    double combineAxisDistances(double bound, double axisBound, DistanceType type);
+
+    // Conversions between reduced and real distances
+    double reducedToDistance(double reduced, DistanceType type, double p = 2.0);
+    double distanceToReduced(double distance, DistanceType type, double p = 2.0);
+}
 
 #endif // DISTANCE_METRICS_H
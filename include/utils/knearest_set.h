@@ -0,0 +1,94 @@
+#ifndef KNEAREST_SET_H
+#define KNEAREST_SET_H
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+
+/**
+ * Fixed-capacity top-k candidate set for k-NN searches
+ * Keeps the k smallest (distance, id) pairs seen so far. Small k uses an
+ * insertion-sorted array; larger k a binary max-heap, so the current k-th
+ * distance is read in O(1) and an accepted candidate costs O(log k).
+ *
+ * Id is whatever identifies a candidate cheaply (point index, node pointer);
+ * coordinates are never copied.
+ */
+template <typename Id = int>
+class KNearestSet {
+public:
+    struct Entry {
+        double distance;
+        Id id;
+
+        bool operator<(const Entry& other) const {
+            return distance < other.distance;
+        }
+    };
+
+    // Arrays up to this size are kept sorted by insertion
+    static constexpr int SORTED_ARRAY_LIMIT = 16;
+
+    explicit KNearestSet(int k) : k(k), useHeap(k > SORTED_ARRAY_LIMIT) {
+        entries.reserve(k > 0 ? k : 0);
+    }
+
+    size_t size() const { return entries.size(); }
+    bool full() const { return entries.size() >= static_cast<size_t>(k); }
+
+    // Distance a candidate must beat to be accepted (infinity until full)
+    double worst() const {
+        if (!full()) return std::numeric_limits<double>::infinity();
+        return useHeap ? entries.front().distance : entries.back().distance;
+    }
+
+    // Returns true if the candidate was accepted
+    bool push(double distance, Id id) {
+        if (k <= 0) return false;
+
+        if (full()) {
+            if (!(distance < worst())) return false;
+
+            if (useHeap) {
+                std::pop_heap(entries.begin(), entries.end());
+                entries.back() = {distance, id};
+                std::push_heap(entries.begin(), entries.end());
+                return true;
+            }
+            entries.pop_back();
+        } else if (useHeap) {
+            entries.push_back({distance, id});
+            std::push_heap(entries.begin(), entries.end());
+            return true;
+        }
+
+        // Insertion into the sorted array, shifting larger entries right
+        entries.push_back({distance, id});
+        size_t i = entries.size() - 1;
+        while (i > 0 && distance < entries[i - 1].distance) {
+            entries[i] = entries[i - 1];
+            i--;
+        }
+        entries[i] = {distance, id};
+        return true;
+    }
+
+    // Candidates in ascending distance order
+    std::vector<Entry> sorted() const {
+        std::vector<Entry> result = entries;
+        if (useHeap) {
+            std::sort_heap(result.begin(), result.end());
+        }
+        return result;
+    }
+
+    void clear() { entries.clear(); }
+
+private:
+    int k;
+    bool useHeap;
+    std::vector<Entry> entries;  // max-heap or ascending array
+};
+
+#endif // KNEAREST_SET_H
@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only memory mapping of a whole file
+ * Pages are loaded by the OS on first touch, so opening costs nothing
+ * proportional to the file size, and several processes mapping the same
+ * file share one copy in the page cache. The mapping is page aligned.
+ * Platforms without mmap read the file into a buffer instead.
+ */
+class MappedFile {
+private:
+    const char* base;
+    size_t length;
+#ifdef _WIN32
+    std::vector<char> buffer;
+#endif
+
+public:
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+};
+
+#endif // MAPPED_FILE_H
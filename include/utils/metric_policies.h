@@ -0,0 +1,266 @@
+#ifndef METRIC_POLICIES_H
+#define METRIC_POLICIES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "distance_metrics.h"
+#include "distance_kernels.h"
+
+/**
+ * Compile-time distance metric policies
+ * Search loops are written once as templates over a policy type and
+ * instantiated per metric, so the metric is fixed at compile time and the
+ * innermost loops inline to one branch-free kernel instead of switching on
+ * DistanceType for every distance. withMetric() is the runtime factory: it
+ * maps a DistanceType (and Minkowski p) to a policy object and calls the
+ * search with it, once per query.
+ *
+ * Row, column and axis functions are templates over the scalar type, so
+ * float32 data runs the float kernels (twice the SIMD lanes) and mixed
+ * precision folds float coordinates into double sums (see reducedAs).
+ *
+ * Every policy provides:
+ * - reduced(a, b, dims): reduced distance between two rows (see
+ *   DistanceMetrics::reducedDistance)
+ * - reducedMany(query, rows, count, dims, out): the same against count
+ *   contiguous rows
+ * - accumulate(x, q, out, n): folds one axis of n points into n running
+ *   reduced distances (structure-of-arrays scans)
+ * - axis(diff): lower bound contributed by a single axis offset
+ * - combine(bound, axisBound): adds one axis bound to a per-point bound
+ * - replaceAxis(rd, oldDiff, newDiff): cell bound after one axis offset
+ *   grows from oldDiff to newDiff (Arya & Mount incremental distance)
+ * - toDistance / toReduced: conversions between reduced and real distances
+ */
+namespace MetricPolicy {
+
+// Euclidean (L2); reduced distance is the squared distance
+struct Euclidean {
+    static constexpr DistanceType type = DistanceType::EUCLIDEAN;
+
+    template <class T>
+    T reduced(const T* a, const T* b, size_t dims) const {
+        return DistanceKernels::squaredEuclidean(a, b, dims);
+    }
+    template <class T>
+    void reducedMany(const T* query, const T* rows, size_t count, size_t dims, T* out) const {
+        DistanceKernels::squaredEuclideanMany(query, rows, count, dims, out);
+    }
+    template <class T>
+    void accumulate(const T* x, T q, T* out, size_t n) const {
+        DistanceKernels::accumulateSquared(x, q, out, n);
+    }
+    template <class T>
+    T axis(T diff) const { return diff * diff; }
+    template <class T>
+    T combine(T bound, T axisBound) const { return bound + axisBound; }
+    double replaceAxis(double rd, double oldDiff, double newDiff) const {
+        return rd - axis(oldDiff) + axis(newDiff);
+    }
+    double toDistance(double reduced) const { return std::sqrt(reduced); }
+    double toReduced(double distance) const { return distance * distance; }
+};
+
+// Manhattan (L1)
+struct Manhattan {
+    static constexpr DistanceType type = DistanceType::MANHATTAN;
+
+    template <class T>
+    T reduced(const T* a, const T* b, size_t dims) const {
+        return DistanceKernels::manhattan(a, b, dims);
+    }
+    template <class T>
+    void reducedMany(const T* query, const T* rows, size_t count, size_t dims, T* out) const {
+        DistanceKernels::manhattanMany(query, rows, count, dims, out);
+    }
+    template <class T>
+    void accumulate(const T* x, T q, T* out, size_t n) const {
+        DistanceKernels::accumulateAbs(x, q, out, n);
+    }
+    template <class T>
+    T axis(T diff) const { return std::abs(diff); }
+    template <class T>
+    T combine(T bound, T axisBound) const { return bound + axisBound; }
+    double replaceAxis(double rd, double oldDiff, double newDiff) const {
+        return rd - axis(oldDiff) + axis(newDiff);
+    }
+    double toDistance(double reduced) const { return reduced; }
+    double toReduced(double distance) const { return distance; }
+};
+
+// Chebyshev (L-infinity)
+// Bounds combine by max instead of sum. Moving to the far side of a split
+// never shrinks that axis' offset, so the new cell bound is max(rd, |newDiff|).
+struct Chebyshev {
+    static constexpr DistanceType type = DistanceType::CHEBYSHEV;
+
+    template <class T>
+    T reduced(const T* a, const T* b, size_t dims) const {
+        return DistanceKernels::chebyshev(a, b, dims);
+    }
+    template <class T>
+    void reducedMany(const T* query, const T* rows, size_t count, size_t dims, T* out) const {
+        DistanceKernels::chebyshevMany(query, rows, count, dims, out);
+    }
+    template <class T>
+    void accumulate(const T* x, T q, T* out, size_t n) const {
+        DistanceKernels::accumulateMaxAbs(x, q, out, n);
+    }
+    template <class T>
+    T axis(T diff) const { return std::abs(diff); }
+    template <class T>
+    T combine(T bound, T axisBound) const { return std::max(bound, axisBound); }
+    double replaceAxis(double rd, double, double newDiff) const {
+        return std::max(rd, axis(newDiff));
+    }
+    double toDistance(double reduced) const { return reduced; }
+    double toReduced(double distance) const { return distance; }
+};
+
+// Minkowski (Lp); reduced distance is the sum of p-th powers
+// P > 0 fixes an integer exponent at compile time (powers become repeated
+// multiplications, L1 and L2 reuse the SIMD kernels); Minkowski<> takes any
+// p at run time and goes through std::pow.
+template <int P = 0>
+struct Minkowski {
+    static constexpr DistanceType type = DistanceType::MINKOWSKI;
+
+    double p;
+
+    Minkowski() : p(P) {}
+    explicit Minkowski(double p) : p(P > 0 ? P : p) {}
+
+    template <class T>
+    T power(T absDiff) const {
+        if constexpr (P > 0) {
+            T result = absDiff;
+            for (int i = 1; i < P; i++) result *= absDiff;
+            return result;
+        } else {
+            return static_cast<T>(std::pow(absDiff, static_cast<T>(p)));
+        }
+    }
+
+    template <class T>
+    T reduced(const T* a, const T* b, size_t dims) const {
+        if constexpr (P == 1) return DistanceKernels::manhattan(a, b, dims);
+        if constexpr (P == 2) return DistanceKernels::squaredEuclidean(a, b, dims);
+        T sum = 0;
+        for (size_t i = 0; i < dims; i++) {
+            sum += power(std::abs(a[i] - b[i]));
+        }
+        return sum;
+    }
+    template <class T>
+    void reducedMany(const T* query, const T* rows, size_t count, size_t dims, T* out) const {
+        if constexpr (P == 1) {
+            DistanceKernels::manhattanMany(query, rows, count, dims, out);
+        } else if constexpr (P == 2) {
+            DistanceKernels::squaredEuclideanMany(query, rows, count, dims, out);
+        } else {
+            for (size_t r = 0; r < count; r++) {
+                out[r] = reduced(query, rows + r * dims, dims);
+            }
+        }
+    }
+    template <class T>
+    void accumulate(const T* x, T q, T* out, size_t n) const {
+        if constexpr (P == 1) {
+            DistanceKernels::accumulateAbs(x, q, out, n);
+        } else if constexpr (P == 2) {
+            DistanceKernels::accumulateSquared(x, q, out, n);
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                out[i] += power(std::abs(x[i] - q));
+            }
+        }
+    }
+    template <class T>
+    T axis(T diff) const { return power(std::abs(diff)); }
+    template <class T>
+    T combine(T bound, T axisBound) const { return bound + axisBound; }
+    double replaceAxis(double rd, double oldDiff, double newDiff) const {
+        return rd - axis(oldDiff) + axis(newDiff);
+    }
+    double toDistance(double reduced) const {
+        if constexpr (P == 1) return reduced;
+        if constexpr (P == 2) return std::sqrt(reduced);
+        return std::pow(reduced, 1.0 / p);
+    }
+    double toReduced(double distance) const { return power(distance); }
+};
+
+// Hamming (number of differing coordinates, for discrete features)
+struct Hamming {
+    static constexpr DistanceType type = DistanceType::HAMMING;
+
+    template <class T>
+    T reduced(const T* a, const T* b, size_t dims) const {
+        T count = 0;
+        for (size_t i = 0; i < dims; i++) {
+            count += (a[i] != b[i]) ? T(1) : T(0);
+        }
+        return count;
+    }
+    template <class T>
+    void reducedMany(const T* query, const T* rows, size_t count, size_t dims, T* out) const {
+        for (size_t r = 0; r < count; r++) {
+            out[r] = reduced(query, rows + r * dims, dims);
+        }
+    }
+    template <class T>
+    void accumulate(const T* x, T q, T* out, size_t n) const {
+        for (size_t i = 0; i < n; i++) {
+            out[i] += (x[i] != q) ? T(1) : T(0);
+        }
+    }
+    // Points across the split differ from the query on this axis
+    template <class T>
+    T axis(T diff) const { return (diff != 0) ? T(1) : T(0); }
+    template <class T>
+    T combine(T bound, T axisBound) const { return bound + axisBound; }
+    double replaceAxis(double rd, double oldDiff, double newDiff) const {
+        return rd - axis(oldDiff) + axis(newDiff);
+    }
+    double toDistance(double reduced) const { return reduced; }
+    double toReduced(double distance) const { return distance; }
+};
+
+// Reduced distance between a query and a row stored in another precision,
+// accumulated in Acc (e.g. float32 coordinates summed in double)
+template <class Acc, class Metric, class T>
+Acc reducedAs(const Metric& metric, const Acc* query, const T* row, size_t dims) {
+    Acc sum = 0;
+    for (size_t i = 0; i < dims; i++) {
+        sum = metric.combine(sum, metric.axis(static_cast<Acc>(row[i]) - query[i]));
+    }
+    return sum;
+}
+
+// Runtime factory: calls fn with the policy for type and returns its result.
+// Small integer Minkowski exponents get their compile-time instantiation.
+template <class Fn>
+decltype(auto) withMetric(DistanceType type, double p, Fn&& fn) {
+    switch (type) {
+        case DistanceType::MANHATTAN:
+            return fn(Manhattan{});
+        case DistanceType::CHEBYSHEV:
+            return fn(Chebyshev{});
+        case DistanceType::HAMMING:
+            return fn(Hamming{});
+        case DistanceType::MINKOWSKI:
+            if (p == 1.0) return fn(Minkowski<1>{});
+            if (p == 2.0) return fn(Minkowski<2>{});
+            if (p == 3.0) return fn(Minkowski<3>{});
+            if (p == 4.0) return fn(Minkowski<4>{});
+            return fn(Minkowski<>(p));
+        case DistanceType::EUCLIDEAN:
+        default:
+            return fn(Euclidean{});
+    }
+}
+
+} // namespace MetricPolicy
+
+#endif // METRIC_POLICIES_H
@@ -0,0 +1,14 @@
+#ifndef NEIGHBOR_H
+#define NEIGHBOR_H
+
+/**
+ * One k-NN result: a reference into the model's training set
+ * Lets voting and other consumers read labels or coordinates from the
+ * training set the model already owns instead of copying every neighbor.
+ */
+struct Neighbor {
+    int index;          // position in the training set passed to fit() / build()
+    double distance;    // distance to the query under the model's metric
+};
+
+#endif // NEIGHBOR_H
@@ -0,0 +1,212 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <array>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Minimal fork-join worker pool for data-parallel loops
+ * The calling thread plus numThreads - 1 workers pull fixed-size chunks of
+ * [0, count) from a shared counter, so uneven per-item cost (e.g. k-NN
+ * queries in dense vs. sparse regions) is balanced automatically.
+ * The workers are persistent: they are started once and sleep between
+ * calls, so a call costs a wake-up rather than thread creation (which
+ * dominated the small loops of sort() and nthElement() rounds). Calls made
+ * while the pool is busy - nested in a worker, or concurrent from another
+ * thread - start threads of their own instead.
+ * sort() and nthElement() build on it for bulk index construction.
+ */
+namespace Parallel {
+
+// numThreads <= 0 selects one thread per hardware core
+inline int resolveThreads(int numThreads) {
+    if (numThreads > 0) return numThreads;
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 0 ? static_cast<int>(hw) : 1;
+}
+
+// Runs work(t) for t in [0, threads): 0 on the calling thread, the others
+// on the shared pool's workers, and returns once all have finished. Returns
+// false without running anything if the pool is in use.
+bool runOnPool(int threads, const std::function<void(int)>& work);
+
+// Calls fn(begin, end, worker) for consecutive chunks of [0, count).
+// worker is in [0, threads) and never runs two chunks at once, so it can
+// index per-thread state. The first exception thrown by fn is rethrown.
+template <typename Fn>
+void forEachChunk(size_t count, int numThreads, Fn&& fn, size_t chunkSize = 64) {
+    if (count == 0) return;
+
+    int threads = resolveThreads(numThreads);
+    chunkSize = std::max<size_t>(chunkSize, 1);
+    size_t chunks = (count + chunkSize - 1) / chunkSize;
+    threads = static_cast<int>(std::min<size_t>(threads, chunks));
+
+    if (threads == 1) {
+        for (size_t begin = 0; begin < count; begin += chunkSize) {
+            fn(begin, std::min(begin + chunkSize, count), 0);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto work = [&](int worker) {
+        try {
+            for (size_t begin = next.fetch_add(chunkSize); begin < count;
+                 begin = next.fetch_add(chunkSize)) {
+                fn(begin, std::min(begin + chunkSize, count), worker);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = std::current_exception();
+            next = count;  // Stop handing out chunks
+        }
+    };
+
+    if (!runOnPool(threads, work)) {
+        std::vector<std::thread> pool;
+        pool.reserve(threads - 1);
+        for (int t = 1; t < threads; t++) {
+            pool.emplace_back(work, t);
+        }
+        work(0);
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
+// std::sort on numThreads workers: runs are sorted concurrently, then merged
+// pairwise in rounds. For a strict total order the result is the same as
+// std::sort's.
+template <typename It, typename Compare>
+void sort(It first, It last, Compare comp, int numThreads, size_t serialCutoff = 1 << 15) {
+    size_t n = static_cast<size_t>(last - first);
+    size_t threads = static_cast<size_t>(resolveThreads(numThreads));
+    if (threads == 1 || n < 2 * serialCutoff) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    size_t runs = std::min(threads, n / serialCutoff);
+    size_t width = (n + runs - 1) / runs;
+    forEachChunk(runs, numThreads, [&](size_t begin, size_t end, int) {
+        for (size_t r = begin; r < end; r++) {
+            std::sort(first + std::min(r * width, n), first + std::min((r + 1) * width, n), comp);
+        }
+    }, 1);
+
+    for (; width < n; width *= 2) {
+        size_t pairs = (n + 2 * width - 1) / (2 * width);
+        forEachChunk(pairs, numThreads, [&](size_t begin, size_t end, int) {
+            for (size_t p = begin; p < end; p++) {
+                size_t lo = p * 2 * width;
+                size_t mid = std::min(lo + width, n);
+                size_t hi = std::min(lo + 2 * width, n);
+                std::inplace_merge(first + lo, first + mid, first + hi, comp);
+            }
+        }, 1);
+    }
+}
+
+// std::nth_element with the partitioning of large ranges done on numThreads
+// workers. Each round takes two pivots from an evenly spaced sample,
+// bracketing the quantile of nth (Floyd-Rivest), splits the range three ways
+// (below, between, above) through a buffer - per-chunk counts and a prefix
+// sum give every chunk its own output slots - and keeps the part holding nth,
+// usually the small middle band. A single thread runs std::nth_element.
+template <typename It, typename Compare>
+void nthElement(It first, It nth, It last, Compare comp, int numThreads,
+                size_t serialCutoff = 1 << 15) {
+    using Value = typename std::iterator_traits<It>::value_type;
+    constexpr size_t SAMPLE = 1023;
+    constexpr size_t BAND = 64;     // sample ranks between nth's quantile and either pivot
+    constexpr size_t CHUNK = 1 << 14;
+
+    std::vector<Value> buffer;
+    std::vector<Value> sample(SAMPLE);
+    bool parallel = resolveThreads(numThreads) > 1;
+    while (parallel && static_cast<size_t>(last - first) > serialCutoff) {
+        size_t n = static_cast<size_t>(last - first);
+
+        for (size_t i = 0; i < SAMPLE; i++) {
+            sample[i] = first[i * n / SAMPLE];
+        }
+        size_t rank = static_cast<size_t>(nth - first) * SAMPLE / n;
+        size_t loRank = rank > BAND ? rank - BAND : 0;
+        size_t hiRank = std::min(rank + BAND, SAMPLE - 1);
+        std::nth_element(sample.begin(), sample.begin() + hiRank, sample.end(), comp);
+        std::nth_element(sample.begin(), sample.begin() + loRank, sample.begin() + hiRank, comp);
+        const Value lo = sample[loRank];
+        const Value hi = sample[hiRank];
+
+        // 0: less than lo, 1: from lo to hi, 2: greater than hi
+        auto side = [&](const Value& v) {
+            if (comp(v, lo)) return 0;
+            return comp(hi, v) ? 2 : 1;
+        };
+
+        size_t chunks = (n + CHUNK - 1) / CHUNK;
+        std::vector<std::array<size_t, 3>> offsets(chunks, std::array<size_t, 3>{0, 0, 0});
+        forEachChunk(n, numThreads, [&](size_t begin, size_t end, int) {
+            auto& counts = offsets[begin / CHUNK];
+            for (size_t i = begin; i < end; i++) {
+                counts[side(first[i])]++;
+            }
+        }, CHUNK);
+
+        // Exclusive prefix sums, class by class, turn counts into slots
+        size_t position = 0;
+        for (int c = 0; c < 3; c++) {
+            for (auto& counts : offsets) {
+                size_t count = counts[c];
+                counts[c] = position;
+                position += count;
+            }
+        }
+        size_t lessEnd = offsets.front()[1];
+        size_t middleEnd = offsets.front()[2];
+
+        buffer.resize(n);
+        forEachChunk(n, numThreads, [&](size_t begin, size_t end, int) {
+            auto slots = offsets[begin / CHUNK];
+            for (size_t i = begin; i < end; i++) {
+                buffer[slots[side(first[i])]++] = first[i];
+            }
+        }, CHUNK);
+        forEachChunk(n, numThreads, [&](size_t begin, size_t end, int) {
+            std::copy(buffer.begin() + begin, buffer.begin() + end, first + begin);
+        }, CHUNK);
+
+        size_t target = static_cast<size_t>(nth - first);
+        if (target < lessEnd) {
+            last = first + lessEnd;
+        } else if (target < middleEnd) {
+            // Every element is between the pivots (e.g. all equivalent)
+            if (middleEnd - lessEnd == n) break;
+            last = first + middleEnd;
+            first = first + lessEnd;
+        } else {
+            first = first + middleEnd;
+        }
+    }
+
+    std::nth_element(first, nth, last, comp);
+}
+
+} // namespace Parallel
+
+#endif // PARALLEL_H
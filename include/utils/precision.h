@@ -0,0 +1,18 @@
+#ifndef PRECISION_H
+#define PRECISION_H
+
+/**
+ * Storage and accumulation precision of search engines
+ * FLOAT32 halves the memory of the stored coordinates and doubles the SIMD
+ * width of the distance kernels, at float precision (about 7 significant
+ * digits). MIXED stores float32 coordinates but accumulates distances in
+ * double, which keeps sums of many terms accurate. Queries are always given
+ * as double and rounded to the storage precision where needed.
+ */
+enum class Precision {
+    FLOAT64,    // double storage and arithmetic
+    FLOAT32,    // float storage and arithmetic
+    MIXED       // float storage, double accumulation
+};
+
+#endif // PRECISION_H
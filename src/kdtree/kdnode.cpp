@@ -1,10 +1,31 @@
 #include "../../include/kdtree/kdnode.h"
+#include <algorithm>
+#include <type_traits>
 
-KDNode::KDNode(const Point& p, int d)
-    : point(p), disc(d), loson(nullptr), hison(nullptr) {
+static_assert(std::is_trivially_destructible<KDNode>::value,
+              "arena nodes are freed without running destructors");
+static_assert(sizeof(KDNode) % alignof(double) == 0,
+              "coordinates follow the node in its record");
+
+KDNode::KDNode(const double* coords, int dims, int label, int d, int index)
+    : point(reinterpret_cast<double*>(this + 1)),
+      label(label), disc(d), loson(nullptr), hison(nullptr), index(index) {
+    std::copy(coords, coords + dims, point);
+}
+
+void KDNode::assignPoint(const KDNode& other, int dims) {
+    std::copy(other.point, other.point + dims, point);
+    label = other.label;
+}
+
+Point KDNode::toPoint(int dims) const {
+    return Point(std::vector<double>(point, point + dims), label);
+}
+
+bool KDNode::hasCoordinates(const double* coords, int dims) const {
+    return std::equal(point, point + dims, coords);
 }
 
-KDNode::~KDNode() {
-    delete loson;
-    delete hison;
+size_t KDNode::recordSize(int dims) {
+    return sizeof(KDNode) + dims * sizeof(double);
 }
@@ -1,15 +1,48 @@
 #include "../../include/kdtree/kdtree.h"
+#include "../../include/utils/metric_policies.h"
+#include "../../include/utils/dimensions.h"
+#include "../../include/utils/parallel.h"
+#include "../../include/utils/binary_file.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+KDTree::KDTree(int dimensions, DistanceType metric, double p, int leafSize, Precision precision,
+               SplitRule splitRule)
+    : k(dimensions), root(nullptr), arena(KDNode::recordSize(dimensions)),
+      distance_calc_count(0), node_visit_count(0),
+      distanceMetric(metric), minkowskiP(p), nextIndex(0), leafSize(leafSize),
+      precision(precision), splitRule(splitRule) {
+    if (leafSize <= 0) {
+        throw std::invalid_argument("leafSize must be positive");
+    }
+
+    flatSearch = Dimensions::withDimensions(k, [precision](auto dims) -> FlatSearch {
+        constexpr int D = decltype(dims)::value;
+        switch (precision) {
+            case Precision::FLOAT32: return &KDTree::kNearestFlatRoot<D, float, float>;
+            case Precision::MIXED: return &KDTree::kNearestFlatRoot<D, float, double>;
+            default: return &KDTree::kNearestFlatRoot<D, double, double>;
+        }
+    });
+}
 
-KDTree::KDTree(int dimensions, DistanceType metric, double p)
-    : k(dimensions), root(nullptr), distance_calc_count(0),
-      distanceMetric(metric), minkowskiP(p) {
+// Nodes hold no heap memory, so dropping the arena slabs frees the tree
+KDTree::~KDTree() = default;
+
+KDNode* KDTree::newNode(const double* coords, int label, int disc, int index) {
+    return new (arena.allocate()) KDNode(coords, k, label, disc, index);
 }
 
-KDTree::~KDTree() {
-    delete root;
+void KDTree::clearNodes() {
+    root = nullptr;
+    arena.clear();
 }
 
 // NEXTDISC function from Bentley 1975
@@ -30,6 +63,21 @@ std::vector<double> KDTree::superkey(const Point& point, int j) {
     return sk;
 }
 
+// Compares the superkeys Sj(a) and Sj(b) without materializing them
+// Returns -1 if Sj(a) < Sj(b), 1 if Sj(a) > Sj(b) and 0 if all keys are equal
+int KDTree::compareSuperkey(const Point& a, const Point& b, int j) const {
+    return compareSuperkey(a.coordinates.data(), b.coordinates.data(), j);
+}
+
+int KDTree::compareSuperkey(const double* a, const double* b, int j) const {
+    for (int n = 0; n < k; n++) {
+        int i = (j + n) % k;
+        if (a[i] < b[i]) return -1;
+        if (a[i] > b[i]) return 1;
+    }
+    return 0;
+}
+
 // SUCCESSOR function from Bentley 1975
 KDTree::SuccessorResult KDTree::successor(KDNode* node, const Point& point) {
     int j = node->disc;
@@ -40,12 +88,11 @@ KDTree::SuccessorResult KDTree::successor(KDNode* node, const Point& point) {
         return HISON;
     } else {
         // If Kj are equal, compare superkeys
-        std::vector<double> s_point = superkey(point, j);
-        std::vector<double> s_node = superkey(node->point, j);
+        int cmp = compareSuperkey(point.coordinates.data(), node->point, j);
 
-        if (s_point < s_node) {
+        if (cmp < 0) {
             return LOSON;
-        } else if (s_point > s_node) {
+        } else if (cmp > 0) {
             return HISON;
         } else {
             return EQUAL;
@@ -55,14 +102,18 @@ KDTree::SuccessorResult KDTree::successor(KDNode* node, const Point& point) {
 
 // Algorithm INSERT from Bentley 1975
 bool KDTree::insert(const Point& point) {
+    int index = nextIndex++;
+
     if (point.dimensions() != static_cast<size_t>(k)) {
         std::cerr << "Point dimension does not match!" << std::endl;
         return false;
     }
 
+    unflatten();
+
     // I1: Check if tree is empty
     if (root == nullptr) {
-        root = new KDNode(point, 0);
+        root = newNode(point.coordinates.data(), point.label, 0, index);
         return true;
     }
 
@@ -70,7 +121,7 @@ bool KDTree::insert(const Point& point) {
 
     while (true) {
         // I2: Compare
-        if (Q->point.coordinates == point.coordinates) {
+        if (Q->hasCoordinates(point.coordinates.data(), k)) {
             return false;  // Point already exists
         }
 
@@ -85,7 +136,7 @@ bool KDTree::insert(const Point& point) {
 
         if (*nextSon == nullptr) {
             // I4: Insert new node into tree
-            *nextSon = new KDNode(point, nextdisc(Q->disc));
+            *nextSon = newNode(point.coordinates.data(), point.label, nextdisc(Q->disc), index);
             return true;
         }
 
@@ -94,57 +145,637 @@ bool KDTree::insert(const Point& point) {
     }
 }
 
-// Recursive search for deletion
-KDNode* KDTree::findMin(KDNode* node, int dim, int currentDisc) {
-    if (node == nullptr) return nullptr;
+// Balanced bulk build
+// Each level takes the median of the remaining points in superkey order as its
+// root, so LOSON/HISON hold exactly the points SUCCESSOR would send there.
+// The result is stored as a compact index (see FlatNode) instead of KDNodes.
+void KDTree::build(const std::vector<Point>& points, int numThreads) {
+    std::vector<const double*> rows(points.size());
+    std::vector<int> rowLabels(points.size());
+    std::vector<int> order;
+    order.reserve(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        rows[i] = points[i].coordinates.data();
+        rowLabels[i] = points[i].label;
+        if (points[i].dimensions() != static_cast<size_t>(k)) {
+            std::cerr << "Point dimension does not match!" << std::endl;
+            continue;
+        }
+        order.push_back(static_cast<int>(i));
+    }
 
-    int cd = currentDisc;
+    buildIndex(rows, rowLabels, order, numThreads);
+}
 
-    if (cd == dim) {
-        if (node->loson == nullptr) {
-            return node;
+void KDTree::build(const Dataset& data, int numThreads) {
+    std::vector<const double*> rows(data.size());
+    std::vector<int> order;
+    if (data.dimensions() != static_cast<size_t>(k)) {
+        std::cerr << "Point dimension does not match!" << std::endl;
+    } else {
+        order.resize(data.size());
+        for (size_t i = 0; i < data.size(); i++) {
+            rows[i] = data.rowData(i);
+            order[i] = static_cast<int>(i);
         }
-        return findMin(node->loson, dim, nextdisc(cd));
     }
 
-    KDNode* left = findMin(node->loson, dim, nextdisc(cd));
-    KDNode* right = findMin(node->hison, dim, nextdisc(cd));
+    buildIndex(rows, data.labels(), order, numThreads);
+}
 
-    KDNode* minNode = node;
-    if (left != nullptr && left->point[dim] < minNode->point[dim]) {
-        minNode = left;
+void KDTree::buildIndex(const std::vector<const double*>& rows, const std::vector<int>& rowLabels,
+                        std::vector<int>& order, int numThreads) {
+    clearNodes();
+    nextIndex = static_cast<int>(rows.size());
+
+    // Drop duplicates, as INSERT would: the first occurrence is kept
+    Parallel::sort(order.begin(), order.end(), [this, &rows](int a, int b) {
+        int cmp = compareSuperkey(rows[a], rows[b], 0);
+        return cmp < 0 || (cmp == 0 && a < b);
+    }, numThreads);
+    // (each dropped input is paired with it, to record its slot below)
+    std::vector<std::pair<int, int>> duplicates;
+    size_t kept = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        if (kept > 0 && compareSuperkey(rows[order[kept - 1]], rows[order[i]], 0) == 0) {
+            duplicates.emplace_back(order[i], order[kept - 1]);
+        } else {
+            order[kept++] = order[i];
+        }
     }
-    if (right != nullptr && right->point[dim] < minNode->point[dim]) {
-        minNode = right;
+    order.resize(kept);
+
+    clearIndex();
+    if (order.empty()) return;
+
+    // The top levels are split first (with parallel partitioning), then the
+    // subtrees below them are built concurrently and laid out in preorder
+    size_t n = order.size();
+    BuildTask whole{0, n, 0, {}, {}};
+    if (splitRule == SplitRule::SLIDING_MIDPOINT) {
+        AxisStats stats = axisStats(rows, order, 0, n, numThreads);
+        whole.low = std::move(stats.low);
+        whole.high = std::move(stats.high);
+    }
+    std::vector<BuildTask> tasks;
+    std::vector<BuildPiece> pieces;
+    splitTopLevels(rows, order, std::move(whole), numThreads, tasks, pieces);
+
+    std::vector<std::vector<FlatNode>> subtrees(tasks.size());
+    Parallel::forEachChunk(tasks.size(), numThreads, [&](size_t begin, size_t end, int) {
+        for (size_t t = begin; t < end; t++) {
+            BuildTask& task = tasks[t];
+            buildFlatRec(rows, order, task.begin, task.end, task.disc, task.low, task.high,
+                         subtrees[t]);
+        }
+    }, 1);
+    if (pieces.size() == 1) {
+        nodeStore.swap(subtrees.front());
+    } else {
+        placePieces(pieces, subtrees, 0);
     }
 
-    return minNode;
+    // Partitioning left every bucket contiguous in order; store in that order
+    if (floatStorage()) {
+        floatColumnStore.resize(n * k);
+    } else {
+        columnStore.resize(n * k);
+    }
+    labelStore.resize(n);
+    idStore.resize(n);
+    slotStore.assign(rows.size(), -1);
+    Parallel::forEachChunk(n, numThreads, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) {
+            const double* row = rows[order[i]];
+            for (int d = 0; d < k; d++) {
+                if (floatStorage()) {
+                    floatColumnStore[d * n + i] = static_cast<float>(row[d]);
+                } else {
+                    columnStore[d * n + i] = row[d];
+                }
+            }
+            labelStore[i] = rowLabels[order[i]];
+            idStore[i] = order[i];
+            slotStore[order[i]] = static_cast<int>(i);
+        }
+    }, 4096);
+    for (const auto& duplicate : duplicates) {
+        slotStore[duplicate.first] = -2 - slotStore[duplicate.second];
+    }
+    viewStore();
+}
+
+void KDTree::viewStore() {
+    nodes = nodeStore;
+    columns = columnStore;
+    floatColumns = floatColumnStore;
+    labels = labelStore;
+    ids = idStore;
+    slots = slotStore;
+}
+
+void KDTree::clearIndex() {
+    std::vector<FlatNode>().swap(nodeStore);
+    std::vector<double>().swap(columnStore);
+    std::vector<float>().swap(floatColumnStore);
+    std::vector<int>().swap(labelStore);
+    std::vector<int>().swap(idStore);
+    std::vector<int>().swap(slotStore);
+    mapping.reset();
+    viewStore();
+}
+
+KDNode* KDTree::buildRec(const std::vector<Point>& points, const std::vector<int>& ids,
+                         std::vector<int>& order, size_t begin, size_t end, int disc) {
+    if (begin >= end) return nullptr;
+
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [this, &points, disc](int a, int b) {
+                         return compareSuperkey(points[a], points[b], disc) < 0;
+                     });
+
+    const Point& point = points[order[mid]];
+    KDNode* node = newNode(point.coordinates.data(), point.label, disc, ids[order[mid]]);
+    node->loson = buildRec(points, ids, order, begin, mid, nextdisc(disc));
+    node->hison = buildRec(points, ids, order, mid + 1, end, nextdisc(disc));
+    return node;
+}
+
+KDTree::AxisStats KDTree::axisStats(const std::vector<const double*>& rows,
+                                    const std::vector<int>& order, size_t begin, size_t end,
+                                    int numThreads) const {
+    // Fixed chunks summed in order keep the result independent of numThreads
+    constexpr size_t CHUNK = 1 << 14;
+    size_t n = end - begin;
+    size_t chunks = (n + CHUNK - 1) / CHUNK;
+    const double* shift = rows[order[begin]];
+    std::vector<AxisStats> partial(chunks);
+    Parallel::forEachChunk(n, numThreads, [&](size_t from, size_t to, int) {
+        AxisStats& part = partial[from / CHUNK];
+        part.low.assign(k, INFINITY);
+        part.high.assign(k, -INFINITY);
+        part.sum.assign(k, 0.0);
+        part.sumSq.assign(k, 0.0);
+        for (size_t i = begin + from; i < begin + to; i++) {
+            const double* row = rows[order[i]];
+            for (int d = 0; d < k; d++) {
+                double x = row[d] - shift[d];
+                part.low[d] = std::min(part.low[d], row[d]);
+                part.high[d] = std::max(part.high[d], row[d]);
+                part.sum[d] += x;
+                part.sumSq[d] += x * x;
+            }
+        }
+    }, CHUNK);
+
+    AxisStats stats = std::move(partial.front());
+    for (size_t c = 1; c < chunks; c++) {
+        for (int d = 0; d < k; d++) {
+            stats.low[d] = std::min(stats.low[d], partial[c].low[d]);
+            stats.high[d] = std::max(stats.high[d], partial[c].high[d]);
+            stats.sum[d] += partial[c].sum[d];
+            stats.sumSq[d] += partial[c].sumSq[d];
+        }
+    }
+    return stats;
+}
+
+KDTree::Split KDTree::partition(const std::vector<const double*>& rows, std::vector<int>& order,
+                                size_t begin, size_t end, int disc, const std::vector<double>& low,
+                                const std::vector<double>& high, int numThreads) {
+    size_t n = end - begin;
+    Split split{disc, begin + n / 2, 0.0};
+
+    if (splitRule != SplitRule::CYCLIC) {
+        AxisStats stats = axisStats(rows, order, begin, end, numThreads);
+        // Duplicates are gone, so some axis has a positive spread
+        double best = -1.0;
+        for (int d = 0; d < k; d++) {
+            double spread = stats.high[d] - stats.low[d];
+            double score;
+            switch (splitRule) {
+                case SplitRule::HIGHEST_VARIANCE:
+                    score = stats.sumSq[d] - stats.sum[d] * stats.sum[d] / n;
+                    break;
+                case SplitRule::SLIDING_MIDPOINT:
+                    score = spread > 0 ? high[d] - low[d] : -1.0;
+                    break;
+                default:
+                    score = spread;
+                    break;
+            }
+            if (score > best) {
+                best = score;
+                split.disc = d;
+            }
+        }
+
+        if (splitRule == SplitRule::SLIDING_MIDPOINT) {
+            int d = split.disc;
+            split.value = (low[d] + high[d]) / 2;
+            size_t below = 0;
+            for (size_t i = begin; i < end; i++) {
+                below += rows[order[i]][d] < split.value;
+            }
+            if (below == 0) {
+                split.value = stats.low[d];
+                below = 1;
+            } else if (below == n) {
+                split.value = stats.high[d];
+                below = n - 1;
+            }
+            split.mid = begin + below;
+        }
+    }
+
+    // Superkey order puts the points below the split value first
+    Parallel::nthElement(order.begin() + begin, order.begin() + split.mid, order.begin() + end,
+                         [this, &rows, &split](int a, int b) {
+                             return compareSuperkey(rows[a], rows[b], split.disc) < 0;
+                         }, numThreads);
+    if (splitRule != SplitRule::SLIDING_MIDPOINT) {
+        split.value = rows[order[split.mid]][split.disc];
+    }
+    // Rounding to the storage precision keeps keys <= value <= keys
+    split.value = stored(split.value);
+    return split;
+}
+
+// Splits the top levels of the tree, each range of at least PARALLEL_SPLIT_MIN
+// points partitioned on all workers; smaller ranges become tasks, built as
+// independent subtrees. Superkeys are unique, so every split and bucket is
+// the same for any thread count (only the order inside a bucket may differ).
+void KDTree::splitTopLevels(const std::vector<const double*>& rows, std::vector<int>& order,
+                            BuildTask task, int numThreads, std::vector<BuildTask>& tasks,
+                            std::vector<BuildPiece>& pieces) {
+    if (task.end - task.begin < PARALLEL_SPLIT_MIN) {
+        pieces.push_back({FlatNode{}, static_cast<int>(tasks.size())});
+        tasks.push_back(std::move(task));
+        return;
+    }
+
+    Split split = partition(rows, order, task.begin, task.end, task.disc, task.low, task.high,
+                            numThreads);
+    pieces.push_back({{split.value, split.disc, -1, 0, 0}, -1});
+
+    BuildTask left{task.begin, split.mid, nextdisc(split.disc), task.low, task.high};
+    BuildTask right{split.mid, task.end, nextdisc(split.disc), std::move(task.low),
+                    std::move(task.high)};
+    if (splitRule == SplitRule::SLIDING_MIDPOINT) {
+        left.high[split.disc] = split.value;
+        right.low[split.disc] = split.value;
+    }
+    splitTopLevels(rows, order, std::move(left), numThreads, tasks, pieces);
+    splitTopLevels(rows, order, std::move(right), numThreads, tasks, pieces);
+}
+
+// Appends the subtree of pieces[p] to nodeStore, shifting the node indices of
+// task subtrees to their final position; returns the piece after it
+size_t KDTree::placePieces(const std::vector<BuildPiece>& pieces,
+                           const std::vector<std::vector<FlatNode>>& subtrees, size_t p) {
+    if (pieces[p].task >= 0) {
+        int offset = static_cast<int>(nodeStore.size());
+        for (FlatNode node : subtrees[pieces[p].task]) {
+            if (node.disc != -1) node.hison += offset;
+            nodeStore.push_back(node);
+        }
+        return p + 1;
+    }
+
+    size_t i = nodeStore.size();
+    nodeStore.push_back(pieces[p].node);
+    p = placePieces(pieces, subtrees, p + 1);
+    nodeStore[i].hison = static_cast<int>(nodeStore.size());
+    return placePieces(pieces, subtrees, p);
+}
+
+// Ranges of at most leafSize points become leaf buckets, others are split as
+// the split rule says (the median in superkey order for CYCLIC, as in
+// buildRec). Nodes are appended to out in preorder, so the left subtree of
+// node i starts at i + 1 and whole subtrees are contiguous. Returns the index
+// of the subtree's root in out.
+int KDTree::buildFlatRec(const std::vector<const double*>& rows, std::vector<int>& order,
+                         size_t begin, size_t end, int disc, std::vector<double>& low,
+                         std::vector<double>& high, std::vector<FlatNode>& out) {
+    int i = static_cast<int>(out.size());
+    if (end - begin <= static_cast<size_t>(leafSize)) {
+        out.push_back({0.0, -1, -1, static_cast<int>(begin), static_cast<int>(end)});
+        return i;
+    }
+
+    Split split = partition(rows, order, begin, end, disc, low, high, 1);
+    out.push_back({split.value, split.disc, -1, 0, 0});
+
+    // Children's cells end at the split (only tracked for SLIDING_MIDPOINT)
+    bool cells = splitRule == SplitRule::SLIDING_MIDPOINT;
+    double bound = cells ? high[split.disc] : 0.0;
+    if (cells) high[split.disc] = split.value;
+    buildFlatRec(rows, order, begin, split.mid, nextdisc(split.disc), low, high, out);
+    if (cells) {
+        high[split.disc] = bound;
+        bound = low[split.disc];
+        low[split.disc] = split.value;
+    }
+    int hison = buildFlatRec(rows, order, split.mid, end, nextdisc(split.disc), low, high, out);
+    if (cells) low[split.disc] = bound;
+    out[i].hison = hison;
+    return i;
+}
+
+template <>
+const double* KDTree::column<double>(int d) const {
+    return columns.data() + d * labels.size();
+}
+
+template <>
+const float* KDTree::column<float>(int d) const {
+    return floatColumns.data() + d * labels.size();
+}
+
+double KDTree::coordinate(int d, int i) const {
+    return floatStorage() ? column<float>(d)[i] : column<double>(d)[i];
+}
+
+double KDTree::stored(double x) const {
+    return floatStorage() ? static_cast<float>(x) : x;
+}
+
+size_t KDTree::indexBytes() const {
+    return nodes.size() * sizeof(FlatNode) + columns.size() * sizeof(double) +
+           floatColumns.size() * sizeof(float) +
+           (labels.size() + ids.size() + slots.size()) * sizeof(int);
+}
+
+Point KDTree::pointAt(int i) const {
+    std::vector<double> coords(k);
+    for (int d = 0; d < k; d++) {
+        coords[d] = coordinate(d, i);
+    }
+    return Point(coords, labels[i]);
+}
+
+bool KDTree::pointOf(int index, Point& point) const {
+    if (!indexed() || index < 0 || static_cast<size_t>(index) >= slots.size() ||
+        slots[index] < 0) {
+        return false;
+    }
+    point = pointAt(slots[index]);
+    return true;
 }
 
-KDNode* KDTree::findMax(KDNode* node, int dim, int currentDisc) {
+int KDTree::duplicatesOf(int index) const {
+    if (!indexed() || index < 0 || static_cast<size_t>(index) >= slots.size() ||
+        slots[index] < 0) {
+        return 0;
+    }
+    int dropped = -2 - slots[index];
+    return static_cast<int>(std::count(slots.begin(), slots.end(), dropped));
+}
+
+void KDTree::unflatten() {
+    if (!indexed()) return;
+
+    std::vector<Point> points;
+    points.reserve(labels.size());
+    for (size_t i = 0; i < labels.size(); i++) {
+        points.push_back(pointAt(static_cast<int>(i)));
+    }
+
+    std::vector<int> pointIds(ids.begin(), ids.end());
+    clearIndex();
+
+    std::vector<int> order(points.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<int>(i);
+    }
+    // One slab holds the whole tree, nodes in build order
+    arena.reserve(points.size());
+    root = buildRec(points, pointIds, order, 0, order.size(), 0);
+}
+
+namespace {
+
+// Layout of an index file (see BinaryFile): this header, then the sections
+// it points to
+struct IndexFileHeader {
+    BinaryFile::Preamble preamble;
+    uint32_t nodeSize;      // sizeof(FlatNode) of the writer
+    int32_t dimensions;
+    int32_t metric;
+    int32_t precision;
+    int32_t splitRule;
+    int32_t leafSize;
+    int32_t nextIndex;
+    int32_t reserved;
+    double minkowskiP;
+    uint64_t nodeCount;
+    uint64_t pointCount;
+    uint64_t nodesOffset;
+    uint64_t columnsOffset;   // double or float columns, as precision says
+    uint64_t labelsOffset;
+    uint64_t idsOffset;
+    uint64_t slotsOffset;     // nextIndex entries
+    uint64_t fileSize;
+};
+
+const char INDEX_MAGIC[8] = {'K', 'D', 'T', 'I', 'N', 'D', 'E', 'X'};
+constexpr uint32_t INDEX_VERSION = 2;
+
+} // namespace
+
+void KDTree::save(const std::string& path) const {
+    static_assert(std::is_trivially_copyable<FlatNode>::value, "FlatNode is written as raw bytes");
+    if (!indexed()) {
+        throw std::runtime_error("Only a built k-d tree index can be saved");
+    }
+
+    IndexFileHeader header = {};
+    header.preamble = BinaryFile::makePreamble(INDEX_MAGIC, INDEX_VERSION);
+    header.nodeSize = sizeof(FlatNode);
+    header.dimensions = k;
+    header.metric = static_cast<int32_t>(distanceMetric);
+    header.precision = static_cast<int32_t>(precision);
+    header.splitRule = static_cast<int32_t>(splitRule);
+    header.leafSize = leafSize;
+    header.nextIndex = nextIndex;
+    header.minkowskiP = minkowskiP;
+    header.nodeCount = nodes.size();
+    header.pointCount = labels.size();
+
+    BinaryFile::SectionWriter out(path, sizeof(header));
+    if (!out.isOpen()) {
+        throw std::runtime_error("Cannot open file for writing: " + path);
+    }
+
+    header.nodesOffset = out.write(nodes.data(), nodes.size() * sizeof(FlatNode));
+    if (floatStorage()) {
+        header.columnsOffset = out.write(floatColumns.data(), floatColumns.size() * sizeof(float));
+    } else {
+        header.columnsOffset = out.write(columns.data(), columns.size() * sizeof(double));
+    }
+    header.labelsOffset = out.write(labels.data(), labels.size() * sizeof(int));
+    header.idsOffset = out.write(ids.data(), ids.size() * sizeof(int));
+    header.slotsOffset = out.write(slots.data(), slots.size() * sizeof(int));
+    header.fileSize = out.size();
+
+    if (!out.finish(&header, sizeof(header))) {
+        throw std::runtime_error("Cannot write file: " + path);
+    }
+}
+
+std::unique_ptr<KDTree> KDTree::load(const std::string& path) {
+    auto file = std::make_unique<MappedFile>(path);
+    auto invalid = [&path](const std::string& reason) {
+        return std::runtime_error("Invalid k-d tree index file " + path + ": " + reason);
+    };
+
+    IndexFileHeader header;
+    if (file->size() < sizeof(header)) {
+        throw invalid("truncated header");
+    }
+    std::copy(file->data(), file->data() + sizeof(header), reinterpret_cast<char*>(&header));
+    switch (BinaryFile::checkPreamble(header.preamble, INDEX_MAGIC, INDEX_VERSION)) {
+        case BinaryFile::PreambleCheck::WRONG_MAGIC:
+            throw invalid("not an index file");
+        case BinaryFile::PreambleCheck::WRONG_VERSION:
+            throw invalid("unsupported version " + std::to_string(header.preamble.version));
+        case BinaryFile::PreambleCheck::WRONG_BYTE_ORDER:
+            throw invalid("written on an incompatible platform");
+        case BinaryFile::PreambleCheck::OK:
+            break;
+    }
+    if (header.nodeSize != sizeof(FlatNode)) {
+        throw invalid("written on an incompatible platform");
+    }
+    if (header.dimensions <= 0 || header.leafSize <= 0 || header.nextIndex < 0 ||
+        header.metric < static_cast<int32_t>(DistanceType::EUCLIDEAN) ||
+        header.metric > static_cast<int32_t>(DistanceType::CHEBYSHEV) ||
+        header.precision < static_cast<int32_t>(Precision::FLOAT64) ||
+        header.precision > static_cast<int32_t>(Precision::MIXED) ||
+        header.splitRule < static_cast<int32_t>(SplitRule::CYCLIC) ||
+        header.splitRule > static_cast<int32_t>(SplitRule::SLIDING_MIDPOINT) ||
+        header.nodeCount == 0 || header.pointCount == 0 ||
+        header.pointCount > static_cast<uint64_t>(header.nextIndex)) {
+        throw invalid("bad configuration");
+    }
+    if (header.fileSize != file->size()) {
+        throw invalid("size does not match its header");
+    }
+
+    // Counts are bounded by what the file can hold before any byte size is
+    // computed, so no product below can wrap around
+    size_t scalarSize = header.precision == static_cast<int32_t>(Precision::FLOAT64)
+                            ? sizeof(double) : sizeof(float);
+    uint64_t maxElements = file->size() / scalarSize;
+    if (header.nodeCount > file->size() / sizeof(FlatNode) ||
+        header.pointCount > file->size() / sizeof(int) ||
+        static_cast<uint64_t>(header.dimensions) > maxElements / header.pointCount ||
+        header.nodeCount > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+        throw invalid("counts exceed the file size");
+    }
+
+    auto tree = std::make_unique<KDTree>(header.dimensions,
+                                         static_cast<DistanceType>(header.metric),
+                                         header.minkowskiP, header.leafSize,
+                                         static_cast<Precision>(header.precision),
+                                         static_cast<SplitRule>(header.splitRule));
+    tree->nextIndex = header.nextIndex;
+
+    // Every section must be aligned and lie inside the file
+    uint64_t points = header.pointCount;
+    uint64_t columnBytes = points * header.dimensions *
+                           (tree->floatStorage() ? sizeof(float) : sizeof(double));
+    auto section = [&](uint64_t offset, uint64_t bytes) {
+        if (offset % BinaryFile::SECTION_ALIGNMENT != 0 || offset < sizeof(header) ||
+            offset > file->size() || bytes > file->size() - offset) {
+            throw invalid("section out of bounds");
+        }
+        return file->data() + offset;
+    };
+    const char* nodeData = section(header.nodesOffset, header.nodeCount * sizeof(FlatNode));
+    const char* columnData = section(header.columnsOffset, columnBytes);
+    const char* labelData = section(header.labelsOffset, points * sizeof(int));
+    const char* idData = section(header.idsOffset, points * sizeof(int));
+    const char* slotData = section(header.slotsOffset, header.nextIndex * sizeof(int));
+
+    // Searches use node fields and slots as raw indices, so every one is
+    // checked once: children after their parent in preorder (no cycles),
+    // leaf ranges inside the points and no larger than a leaf bucket
+    const FlatNode* fileNodes = reinterpret_cast<const FlatNode*>(nodeData);
+    uint64_t nodeCount = header.nodeCount;
+    for (uint64_t i = 0; i < nodeCount; i++) {
+        const FlatNode& node = fileNodes[i];
+        bool valid;
+        if (node.disc == -1) {
+            valid = node.begin >= 0 && node.begin <= node.end &&
+                    static_cast<uint64_t>(node.end) <= points &&
+                    node.end - node.begin <= header.leafSize;
+        } else {
+            valid = node.disc >= 0 && node.disc < header.dimensions && i + 1 < nodeCount &&
+                    node.hison > static_cast<int64_t>(i + 1) &&
+                    static_cast<uint64_t>(node.hison) < nodeCount;
+        }
+        if (!valid) {
+            throw invalid("corrupt node " + std::to_string(i));
+        }
+    }
+    const int* fileSlots = reinterpret_cast<const int*>(slotData);
+    for (int32_t i = 0; i < header.nextIndex; i++) {
+        int64_t slot = fileSlots[i] >= 0 ? fileSlots[i] : -2 - static_cast<int64_t>(fileSlots[i]);
+        if (slot < 0 || static_cast<uint64_t>(slot) >= points) {
+            throw invalid("corrupt slot " + std::to_string(i));
+        }
+    }
+    // Searches report ids as neighbor indices, which labelOf() maps back
+    // through slots: each id must be an input index whose slot is this point
+    const int* fileIds = reinterpret_cast<const int*>(idData);
+    for (uint64_t i = 0; i < points; i++) {
+        if (fileIds[i] < 0 || fileIds[i] >= header.nextIndex ||
+            static_cast<uint64_t>(fileSlots[fileIds[i]]) != i) {
+            throw invalid("corrupt id " + std::to_string(i));
+        }
+    }
+
+    tree->nodes = {reinterpret_cast<const FlatNode*>(nodeData), header.nodeCount};
+    if (tree->floatStorage()) {
+        tree->floatColumns = {reinterpret_cast<const float*>(columnData), points * header.dimensions};
+    } else {
+        tree->columns = {reinterpret_cast<const double*>(columnData), points * header.dimensions};
+    }
+    tree->labels = {reinterpret_cast<const int*>(labelData), points};
+    tree->ids = {reinterpret_cast<const int*>(idData), points};
+    tree->slots = {reinterpret_cast<const int*>(slotData), static_cast<size_t>(header.nextIndex)};
+    tree->mapping = std::move(file);
+    return tree;
+}
+
+// Recursive search for deletion: the node of least superkey S_dim, which
+// SUCCESSOR orders every other node of the subtree against
+KDNode* KDTree::findMin(KDNode* node, int dim, int currentDisc) {
     if (node == nullptr) return nullptr;
 
     int cd = currentDisc;
 
     if (cd == dim) {
-        if (node->hison == nullptr) {
+        if (node->loson == nullptr) {
             return node;
         }
-        return findMax(node->hison, dim, nextdisc(cd));
+        return findMin(node->loson, dim, nextdisc(cd));
     }
 
-    KDNode* left = findMax(node->loson, dim, nextdisc(cd));
-    KDNode* right = findMax(node->hison, dim, nextdisc(cd));
+    KDNode* left = findMin(node->loson, dim, nextdisc(cd));
+    KDNode* right = findMin(node->hison, dim, nextdisc(cd));
 
-    KDNode* maxNode = node;
-    if (left != nullptr && left->point[dim] > maxNode->point[dim]) {
-        maxNode = left;
+    KDNode* minNode = node;
+    if (left != nullptr && compareSuperkey(left->point, minNode->point, dim) < 0) {
+        minNode = left;
     }
-    if (right != nullptr && right->point[dim] > maxNode->point[dim]) {
-        maxNode = right;
+    if (right != nullptr && compareSuperkey(right->point, minNode->point, dim) < 0) {
+        minNode = right;
     }
 
-    return maxNode;
+    return minNode;
 }
 
 // DELETE algorithm from Bentley 1975
@@ -154,10 +785,10 @@ KDNode* KDTree::deleteNode(KDNode* node, const Point& point) {
     int j = node->disc;
 
     // If we found the node to delete
-    if (node->point.coordinates == point.coordinates) {
+    if (node->hasCoordinates(point.coordinates.data(), k)) {
         // D1: Is P a leaf?
         if (node->hison == nullptr && node->loson == nullptr) {
-            delete node;
+            arena.release(node);
             return nullptr;
         }
 
@@ -166,13 +797,16 @@ KDNode* KDTree::deleteNode(KDNode* node, const Point& point) {
         if (node->hison != nullptr) {
             // D3: Get next root from HISON(P)
             replacement = findMin(node->hison, j, nextdisc(j));
-            node->point = replacement->point;
-            node->hison = deleteNode(node->hison, replacement->point);
+            node->assignPoint(*replacement, k);
+            node->index = replacement->index;
+            node->hison = deleteNode(node->hison, replacement->toPoint(k));
         } else {
-            // D4: Get next root from LOSON(P)
-            replacement = findMax(node->loson, j, nextdisc(j));
-            node->point = replacement->point;
-            node->hison = deleteNode(node->loson, replacement->point);
+            // D4: Take the least node of LOSON(P) as next root and move the
+            // rest of LOSON(P) to HISON(P), where all of it now belongs
+            replacement = findMin(node->loson, j, nextdisc(j));
+            node->assignPoint(*replacement, k);
+            node->index = replacement->index;
+            node->hison = deleteNode(node->loson, replacement->toPoint(k));
             node->loson = nullptr;
         }
 
@@ -194,7 +828,7 @@ KDNode* KDTree::deleteNode(KDNode* node, const Point& point) {
 KDNode* KDTree::searchRec(KDNode* node, const Point& point) {
     if (node == nullptr) return nullptr;
 
-    if (node->point.coordinates == point.coordinates) {
+    if (node->hasCoordinates(point.coordinates.data(), k)) {
         return node;
     }
 
@@ -208,11 +842,39 @@ KDNode* KDTree::searchRec(KDNode* node, const Point& point) {
     }
 }
 
+// Point search over the compact index
+// Keys equal to the split value may sit on either side, so both are searched
+bool KDTree::searchFlat(int i, const Point& point) const {
+    const FlatNode& node = nodes[i];
+
+    if (node.disc == -1) {
+        for (int j = node.begin; j < node.end; j++) {
+            int d = 0;
+            while (d < k && coordinate(d, j) == stored(point[d])) d++;
+            if (d == k) return true;
+        }
+        return false;
+    }
+
+    double key = stored(point[node.disc]);
+    if (key <= node.split && searchFlat(i + 1, point)) {
+        return true;
+    }
+    return key >= node.split && searchFlat(node.hison, point);
+}
+
 bool KDTree::search(const Point& point) {
+    if (point.dimensions() != static_cast<size_t>(k)) {
+        return false;
+    }
+    if (indexed()) {
+        return searchFlat(0, point);
+    }
     return searchRec(root, point) != nullptr;
 }
 
 void KDTree::remove(const Point& point) {
+    unflatten();
     root = deleteNode(root, point);
 }
 
@@ -221,47 +883,126 @@ void KDTree::inorderRec(KDNode* node) {
     if (node != nullptr) {
         inorderRec(node->loson);
         std::cout << "(";
-        for (size_t i = 0; i < node->point.dimensions(); i++) {
+        for (int i = 0; i < k; i++) {
             std::cout << node->point[i];
-            if (i < node->point.dimensions() - 1) std::cout << ",";
+            if (i < k - 1) std::cout << ",";
         }
-        std::cout << ") label=" << node->point.label
+        std::cout << ") label=" << node->label
                   << " disc=" << node->disc << std::endl;
         inorderRec(node->hison);
     }
 }
 
+void KDTree::inorderFlat(int i) const {
+    const FlatNode& node = nodes[i];
+
+    if (node.disc == -1) {
+        for (int j = node.begin; j < node.end; j++) {
+            std::cout << "(";
+            for (int d = 0; d < k; d++) {
+                std::cout << coordinate(d, j);
+                if (d < k - 1) std::cout << ",";
+            }
+            std::cout << ") label=" << labels[j] << " leaf=" << i << std::endl;
+        }
+        return;
+    }
+
+    inorderFlat(i + 1);
+    std::cout << "split=" << node.split << " disc=" << node.disc << std::endl;
+    inorderFlat(node.hison);
+}
+
 void KDTree::inorder() {
+    if (indexed()) {
+        inorderFlat(0);
+        return;
+    }
     inorderRec(root);
 }
 
-// Distance calculation (supports multiple metrics)
-double KDTree::distance(const Point& a, const Point& b) {
-    distance_calc_count++;  // Track distance calculations
+int KDTree::heightRec(KDNode* node) const {
+    if (node == nullptr) return 0;
+    return 1 + std::max(heightRec(node->loson), heightRec(node->hison));
+}
+
+int KDTree::heightFlat(int i) const {
+    if (nodes[i].disc == -1) return 1;
+    return 1 + std::max(heightFlat(i + 1), heightFlat(nodes[i].hison));
+}
 
-    switch (distanceMetric) {
-        case DistanceType::EUCLIDEAN:
-            return DistanceMetrics::euclidean(a, b);
-        case DistanceType::MANHATTAN:
-            return DistanceMetrics::manhattan(a, b);
-        case DistanceType::HAMMING:
-            return DistanceMetrics::hamming(a, b);
-        case DistanceType::MINKOWSKI:
-            return DistanceMetrics::minkowski(a, b, minkowskiP);
-        default:
-            return DistanceMetrics::euclidean(a, b);
+int KDTree::height() const {
+    if (indexed()) {
+        return heightFlat(0);
+    }
+    return heightRec(root);
+}
+
+// Reduced distances from target to every point of a leaf bucket
+// With a runtime dimension, loops run over the bucket for one axis at a time,
+// which keeps the inner loop a contiguous scan over a coordinate column (SIMD
+// kernels for L1, L2 and L-infinity). With D fixed, the axis loop unrolls
+// and each distance is finished in a single pass over the bucket.
+template <int D, class T, class Acc, class Metric>
+void KDTree::leafDistances(SearchState& state, const FlatNode& leaf, const Metric& metric) const {
+    int count = leaf.end - leaf.begin;
+    const double* target = state.target;
+    double* out = state.scratch.data();
+
+    if constexpr (D != Dimensions::DYNAMIC) {
+        Acc q[D];
+        const T* x[D];
+        for (int d = 0; d < D; d++) {
+            q[d] = static_cast<Acc>(target[d]);
+            x[d] = column<T>(d) + leaf.begin;
+        }
+        for (int j = 0; j < count; j++) {
+            Acc sum = 0;
+            for (int d = 0; d < D; d++) {
+                sum = metric.combine(sum, metric.axis(static_cast<Acc>(x[d][j]) - q[d]));
+            }
+            out[j] = sum;
+        }
+    } else if constexpr (std::is_same<T, Acc>::value) {
+        // Column kernels in the storage precision
+        Acc* acc;
+        if constexpr (std::is_same<Acc, float>::value) {
+            acc = state.floatScratch.data();
+        } else {
+            acc = out;
+        }
+        std::fill(acc, acc + count, Acc(0));
+        for (int d = 0; d < k; d++) {
+            metric.accumulate(column<T>(d) + leaf.begin, static_cast<T>(target[d]), acc, count);
+        }
+        if constexpr (std::is_same<Acc, float>::value) {
+            std::copy(acc, acc + count, out);
+        }
+    } else {
+        // Stored coordinates folded into sums of the wider accumulation type
+        std::fill(out, out + count, 0.0);
+        for (int d = 0; d < k; d++) {
+            const T* x = column<T>(d) + leaf.begin;
+            Acc q = static_cast<Acc>(target[d]);
+            for (int j = 0; j < count; j++) {
+                out[j] = metric.combine(static_cast<Acc>(out[j]),
+                                        metric.axis(static_cast<Acc>(x[j]) - q));
+            }
+        }
     }
 }
 
 // Nearest neighbor search (recursive)
-void KDTree::nearestNeighborRec(KDNode* node, const Point& target,
-                                Point& best, double& bestDist) {
+template <class Metric>
+void KDTree::nearestNeighborRec(KDNode* node, const Point& target, Point& best, double& bestDist,
+                                long long& distances, const Metric& metric) const {
     if (node == nullptr) return;
 
-    double d = distance(target, node->point);
+    distances++;  // Track distance calculations
+    double d = metric.reduced(target.coordinates.data(), node->point, k);
     if (d < bestDist) {
         bestDist = d;
-        best = node->point;
+        best = node->toPoint(k);
     }
 
     int j = node->disc;
@@ -270,43 +1011,59 @@ void KDTree::nearestNeighborRec(KDNode* node, const Point& target,
     KDNode* near = (diff < 0) ? node->loson : node->hison;
     KDNode* far = (diff < 0) ? node->hison : node->loson;
 
-    nearestNeighborRec(near, target, best, bestDist);
+    nearestNeighborRec(near, target, best, bestDist, distances, metric);
 
-    if (std::abs(diff) < bestDist) {
-        nearestNeighborRec(far, target, best, bestDist);
+    if (metric.axis(diff) < bestDist) {
+        nearestNeighborRec(far, target, best, bestDist, distances, metric);
     }
 }
 
-Point KDTree::nearestNeighbor(const Point& target) {
+void KDTree::checkQuery(size_t dims) const {
+    if (dims != static_cast<size_t>(k)) {
+        throw std::invalid_argument("Query dimension does not match");
+    }
+}
+
+Point KDTree::nearestNeighbor(const Point& target) const {
+    checkQuery(target.dimensions());
+    if (indexed()) {
+        SearchState state(target.coordinates.data(), 1, k, leafSize, precision);
+        kNearestFlat(state);
+        distance_calc_count += state.distances;
+        return pointAt(state.candidates.sorted().front().id);
+    }
+
     if (root == nullptr) {
         return Point();  // Return empty point
     }
 
-    Point best = root->point;
-    double bestDist = distance(target, root->point);
-
-    nearestNeighborRec(root, target, best, bestDist);
+    Point best = root->toPoint(k);
+    long long distances = 0;
+    MetricPolicy::withMetric(distanceMetric, minkowskiP, [&](const auto& metric) {
+        double bestDist = metric.reduced(target.coordinates.data(), root->point, k);
+        distances++;
+        nearestNeighborRec(root, target, best, bestDist, distances, metric);
+    });
+    distance_calc_count += distances;
 
     return best;
 }
 
 // k-NN search - recursive helper
-void KDTree::kNearestRec(KDNode* node, const Point& target,
-                        std::vector<NeighborCandidate>& candidates, int k) {
+// rd is the reduced distance from target to the cell of node: offsets holds,
+// per axis, how far target lies outside the cell (Arya & Mount incremental
+// distance), so a far subtree is skipped when its whole cell is too far away
+// rather than only when the single splitting plane is.
+template <class Metric>
+void KDTree::kNearestRec(KDNode* node, const Point& target, double rd,
+                         std::vector<double>& offsets, KNearestSet<const KDNode*>& candidates,
+                         long long& distances, const Metric& metric) const {
     if (node == nullptr) return;
 
-    // Calculate distance to current node
-    double dist = distance(target, node->point);
-
-    // Add to candidates if we have less than k, or if this is closer than the worst candidate
-    if (candidates.size() < static_cast<size_t>(k)) {
-        candidates.push_back({node->point, dist});
-        std::sort(candidates.begin(), candidates.end());
-    } else if (dist < candidates.back().distance) {
-        // Replace worst candidate
-        candidates.back() = {node->point, dist};
-        std::sort(candidates.begin(), candidates.end());
-    }
+    // Calculate distance to current node; kept only if closer than the worst candidate
+    distances++;  // Track distance calculations
+    candidates.push(metric.reduced(target.coordinates.data(), node->point, k),
+                    node);
 
     // Determine which subtree to search first
     int j = node->disc;
@@ -315,32 +1072,210 @@ void KDTree::kNearestRec(KDNode* node, const Point& target,
     KDNode* near = (diff < 0) ? node->loson : node->hison;
     KDNode* far = (diff < 0) ? node->hison : node->loson;
 
-    // Search near subtree first
-    kNearestRec(near, target, candidates, k);
+    // Search near subtree first (same cell distance)
+    kNearestRec(near, target, rd, offsets, candidates, distances, metric);
 
-    // Check if we need to search far subtree
-    // If we don't have k neighbors yet, or if the splitting plane is close enough
-    if (candidates.size() < static_cast<size_t>(k) ||
-        std::abs(diff) < candidates.back().distance) {
-        kNearestRec(far, target, candidates, k);
+    // The far cell lies across the splitting plane: replace this axis' offset
+    double oldOffset = offsets[j];
+    double farRd = metric.replaceAxis(rd, oldOffset, diff);
+    if (farRd < candidates.worst()) {
+        offsets[j] = diff;
+        kNearestRec(far, target, farRd, offsets, candidates, distances, metric);
+        offsets[j] = oldOffset;
     }
 }
 
+// k-NN search over the compact index, with the same incremental cell bound
+template <int D, class T, class Acc, class Metric>
+void KDTree::kNearestFlat(int i, double rd, SearchState& state, const Metric& metric) const {
+    const FlatNode& node = nodes[i];
+    state.visits++;
+
+    if (node.disc == -1) {
+        leafDistances<D, T, Acc>(state, node, metric);
+        state.distances += node.end - node.begin;  // Track distance calculations
+
+        for (int j = node.begin; j < node.end; j++) {
+            state.candidates.push(state.scratch[j - node.begin], j);
+        }
+        return;
+    }
+
+    double diff = state.target[node.disc] - node.split;
+
+    int near = (diff < 0) ? i + 1 : node.hison;
+    int far = (diff < 0) ? node.hison : i + 1;
+
+    kNearestFlat<D, T, Acc>(near, rd, state, metric);
+
+    double oldOffset = state.offsets[node.disc];
+    double farRd = metric.replaceAxis(rd, oldOffset, diff);
+    if (farRd < state.candidates.worst()) {
+        state.offsets[node.disc] = diff;
+        kNearestFlat<D, T, Acc>(far, farRd, state, metric);
+        state.offsets[node.disc] = oldOffset;
+    }
+}
+
+template <int D, class T, class Acc>
+void KDTree::kNearestFlatRoot(SearchState& state) const {
+    MetricPolicy::withMetric(distanceMetric, minkowskiP, [&](const auto& metric) {
+        kNearestFlat<D, T, Acc>(0, 0.0, state, metric);
+    });
+}
+
 // k-NN search - public interface
-std::vector<Point> KDTree::kNearestNeighbors(const Point& target, int k) {
-    if (root == nullptr || k <= 0) {
+std::vector<Point> KDTree::kNearestNeighbors(const Point& target, int k) const {
+    long long distances = 0;
+    auto result = kNearestNeighbors(target, k, distances);
+    distance_calc_count += distances;
+    return result;
+}
+
+std::vector<Point> KDTree::kNearestNeighbors(const Point& target, int k, long long& distances) const {
+    checkQuery(target.dimensions());
+    if (k <= 0) {
         return {};
     }
 
-    std::vector<NeighborCandidate> candidates;
-    kNearestRec(root, target, candidates, k);
+    std::vector<Point> result;
+
+    if (indexed()) {
+        SearchState state(target.coordinates.data(), k, this->k, leafSize, precision);
+        kNearestFlat(state);
+        distances += state.distances;
+
+        result.reserve(state.candidates.size());
+        for (const auto& candidate : state.candidates.sorted()) {
+            result.push_back(pointAt(candidate.id));
+        }
+        return result;
+    }
+
+    if (root == nullptr) {
+        return {};
+    }
+
+    KNearestSet<const KDNode*> candidates(k);
+    std::vector<double> offsets(this->k, 0.0);
+    MetricPolicy::withMetric(distanceMetric, minkowskiP, [&](const auto& metric) {
+        kNearestRec(root, target, 0.0, offsets, candidates, distances, metric);
+    });
 
     // Extract points from candidates
-    std::vector<Point> result;
     result.reserve(candidates.size());
-    for (const auto& candidate : candidates) {
-        result.push_back(candidate.point);
+    for (const auto& candidate : candidates.sorted()) {
+        result.push_back(candidate.id->toPoint(this->k));
+    }
+
+    return result;
+}
+
+std::vector<Neighbor> KDTree::toNeighbors(const std::vector<KNearestSet<int>::Entry>& found) const {
+    std::vector<Neighbor> result;
+    result.reserve(found.size());
+    for (const auto& candidate : found) {
+        result.push_back({ids[candidate.id],
+                          DistanceMetrics::reducedToDistance(candidate.distance, distanceMetric, minkowskiP)});
     }
+    return result;
+}
 
+std::vector<Neighbor> KDTree::kNearestNeighborIndices(RowView target, int k) const {
+    long long distances = 0;
+    auto result = kNearestNeighborIndices(target, k, distances);
+    distance_calc_count += distances;
     return result;
 }
+
+std::vector<Neighbor> KDTree::kNearestNeighborIndices(RowView target, int k,
+                                                      long long& distances) const {
+    checkQuery(target.dimensions());
+    if (k <= 0) {
+        return {};
+    }
+
+    if (indexed()) {
+        SearchState state(target.data, k, this->k, leafSize, precision);
+        kNearestFlat(state);
+        distances += state.distances;
+        return toNeighbors(state.candidates.sorted());
+    }
+
+    if (root == nullptr) {
+        return {};
+    }
+
+    // The linked tree compares whole Points
+    KNearestSet<const KDNode*> candidates(k);
+    std::vector<double> offsets(this->k, 0.0);
+    Point query = target.toPoint();
+    MetricPolicy::withMetric(distanceMetric, minkowskiP, [&](const auto& metric) {
+        kNearestRec(root, query, 0.0, offsets, candidates, distances, metric);
+    });
+
+    std::vector<Neighbor> result;
+    result.reserve(candidates.size());
+    for (const auto& candidate : candidates.sorted()) {
+        result.push_back({candidate.id->index,
+                          DistanceMetrics::reducedToDistance(candidate.distance, distanceMetric, minkowskiP)});
+    }
+    return result;
+}
+
+std::vector<std::vector<Point>> KDTree::kNearestNeighborsBatch(const std::vector<Point>& queries,
+                                                               int k, int numThreads) const {
+    std::vector<std::vector<Point>> results(queries.size());
+    std::vector<long long> distances(Parallel::resolveThreads(numThreads), 0);
+
+    Parallel::forEachChunk(queries.size(), numThreads,
+        [&](size_t begin, size_t end, int worker) {
+            for (size_t i = begin; i < end; i++) {
+                results[i] = kNearestNeighbors(queries[i], k, distances[worker]);
+            }
+        });
+
+    for (long long count : distances) {
+        distance_calc_count += count;
+    }
+    return results;
+}
+
+std::vector<std::vector<Neighbor>> KDTree::kNearestNeighborIndicesBatch(const std::vector<Point>& queries,
+                                                                        int k, int numThreads) const {
+    std::vector<std::vector<Neighbor>> results(queries.size());
+    std::vector<long long> distances(Parallel::resolveThreads(numThreads), 0);
+
+    Parallel::forEachChunk(queries.size(), numThreads,
+        [&](size_t begin, size_t end, int worker) {
+            for (size_t i = begin; i < end; i++) {
+                results[i] = kNearestNeighborIndices(queries[i], k, distances[worker]);
+            }
+        });
+
+    for (long long count : distances) {
+        distance_calc_count += count;
+    }
+    return results;
+}
+
+std::vector<std::vector<Neighbor>> KDTree::kNearestNeighborIndicesBatch(const Dataset& queries,
+                                                                        int k, int numThreads) const {
+    if (!queries.empty()) {
+        checkQuery(queries.dimensions());
+    }
+    std::vector<std::vector<Neighbor>> results(queries.size());
+    std::vector<long long> distances(Parallel::resolveThreads(numThreads), 0);
+
+    Parallel::forEachChunk(queries.size(), numThreads,
+        [&](size_t begin, size_t end, int worker) {
+            for (size_t i = begin; i < end; i++) {
+                results[i] = kNearestNeighborIndices(queries.row(i), k, distances[worker]);
+            }
+        });
+
+    for (long long count : distances) {
+        distance_calc_count += count;
+    }
+    return results;
+}
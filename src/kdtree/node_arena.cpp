@@ -0,0 +1,61 @@
+#include "../../include/kdtree/node_arena.h"
+#include <algorithm>
+
+NodeArena::NodeArena(size_t recordSize, size_t slabBytes)
+    : recordSize(0), slabRecords(0), cursor(nullptr), slabEnd(nullptr), freeList(nullptr),
+      live(0), slabBytesTotal(0) {
+    constexpr size_t ALIGN = alignof(std::max_align_t);
+    size_t size = std::max(recordSize, sizeof(FreeRecord));
+    this->recordSize = (size + ALIGN - 1) / ALIGN * ALIGN;
+    slabRecords = std::max<size_t>(1, slabBytes / this->recordSize);
+}
+
+void NodeArena::addSlab(size_t records) {
+    // new char[] storage is aligned for any fundamental type
+    size_t size = records * recordSize;
+    slabs.emplace_back(new char[size]);
+    cursor = slabs.back().get();
+    slabEnd = cursor + size;
+    slabBytesTotal += size;
+}
+
+void* NodeArena::allocate() {
+    live++;
+    if (freeList != nullptr) {
+        FreeRecord* record = freeList;
+        freeList = record->next;
+        return record;
+    }
+
+    if (cursor == slabEnd) {
+        addSlab(slabRecords);
+    }
+    void* record = cursor;
+    cursor += recordSize;
+    return record;
+}
+
+void NodeArena::release(void* record) {
+    if (record == nullptr) return;
+
+    FreeRecord* freed = static_cast<FreeRecord*>(record);
+    freed->next = freeList;
+    freeList = freed;
+    live--;
+}
+
+void NodeArena::reserve(size_t count) {
+    size_t available = static_cast<size_t>(slabEnd - cursor) / recordSize;
+    if (count > available) {
+        addSlab(std::max(count, slabRecords));
+    }
+}
+
+void NodeArena::clear() {
+    slabs.clear();
+    cursor = nullptr;
+    slabEnd = nullptr;
+    freeList = nullptr;
+    live = 0;
+    slabBytesTotal = 0;
+}
@@ -1,122 +1,269 @@
 #include "../../include/knn/knn_basic.h"
+#include "../../include/utils/knearest_set.h"
+#include "../../include/utils/metric_policies.h"
+#include "../../include/utils/parallel.h"
 #include <algorithm>
 #include <map>
 #include <stdexcept>
 #include <chrono>
 
-KNNBasic::KNNBasic(int k_neighbors, DistanceType metric, double p)
-    : k(k_neighbors), distanceMetric(metric), minkowskiP(p) {
+KNNBasic::KNNBasic(int k_neighbors, DistanceType metric, double p, Precision precision)
+    : k(k_neighbors), distanceMetric(metric), minkowskiP(p), precision(precision),
+      streamChunkRows(CSVChunkReader::DEFAULT_CHUNK_ROWS), streamHeader(true),
+      streamLabelColumn(-1), streamDims(0) {
     if (k <= 0) {
         throw std::invalid_argument("k must be positive");
     }
 }
 
 void KNNBasic::fit(const std::vector<Point>& data) {
-    trainingData = data;
+    fit(Dataset::fromPoints(data));
 }
 
-double KNNBasic::calculateDistance(const Point& a, const Point& b) const {
-    switch (distanceMetric) {
-        case DistanceType::EUCLIDEAN:
-            return DistanceMetrics::euclidean(a, b);
-        case DistanceType::MANHATTAN:
-            return DistanceMetrics::manhattan(a, b);
-        case DistanceType::HAMMING:
-            return DistanceMetrics::hamming(a, b);
-        case DistanceType::MINKOWSKI:
-            return DistanceMetrics::minkowski(a, b, minkowskiP);
-        default:
-            return DistanceMetrics::euclidean(a, b);
-    }
-}
+void KNNBasic::fit(const Dataset& data) {
+    trainingData = data;
+    streamPath.clear();
 
-std::vector<Point> KNNBasic::findKNearest(const Point& query) {
-    if (trainingData.empty()) {
-        throw std::runtime_error("No training data. Call fit() first.");
+    floatRows.clear();
+    if (precision != Precision::FLOAT64) {
+        floatRows.assign(data.data(), data.data() + data.size() * data.dimensions());
     }
+}
 
-    // Calculate distances for all training points
-    std::vector<std::pair<double, Point>> distances;
-    distances.reserve(trainingData.size());
-
-    for (const auto& point : trainingData) {
-        double dist = calculateDistance(query, point);
-        distances.push_back({dist, point});
+void KNNBasic::fitStream(const std::string& filepath, size_t chunkRows, bool hasHeader,
+                         int labelColumn) {
+    // Reading the first chunk checks the file and fixes the dimensionality
+    CSVChunkReader reader(filepath, chunkRows, hasHeader, labelColumn);
+    Dataset chunk;
+    if (!reader.next(chunk)) {
+        throw std::runtime_error("No data rows in file: " + filepath);
     }
 
-    // Sort by distance (brute force approach)
-    std::sort(distances.begin(), distances.end(),
-              [](const auto& a, const auto& b) { return a.first < b.first; });
+    trainingData = Dataset();
+    floatRows.clear();
+    streamPath = filepath;
+    streamChunkRows = chunkRows;
+    streamHeader = hasHeader;
+    streamLabelColumn = labelColumn;
+    streamDims = reader.dimensions();
+}
 
-    // Get k nearest neighbors
-    std::vector<Point> neighbors;
-    int limit = std::min(k, static_cast<int>(distances.size()));
-    neighbors.reserve(limit);
+size_t KNNBasic::trainingDimensions() const {
+    return isStreaming() ? streamDims : trainingData.dimensions();
+}
 
-    for (int i = 0; i < limit; i++) {
-        neighbors.push_back(distances[i].second);
-    }
+void KNNBasic::scanChunk(const Dataset& chunk, const float* chunkFloats, size_t firstIndex,
+                         const Dataset& queries, const float* queryFloats,
+                         std::vector<CandidateSet>& nearest, int numThreads) const {
+    size_t n = chunk.size();
+    size_t dims = chunk.dimensions();
 
-    return neighbors;
+    // Each worker takes a run of queries and walks the chunk a block of rows
+    // at a time, scoring the whole run against a block while it is in cache
+    MetricPolicy::withMetric(distanceMetric, minkowskiP, [&](const auto& metric) {
+        Parallel::forEachChunk(queries.size(), numThreads,
+                               [&](size_t qBegin, size_t qEnd, int) {
+            double block[BLOCK_ROWS];
+            float floatBlock[BLOCK_ROWS];
+            for (size_t begin = 0; begin < n; begin += BLOCK_ROWS) {
+                size_t count = std::min(BLOCK_ROWS, n - begin);
+                for (size_t q = qBegin; q < qEnd; q++) {
+                    if (precision == Precision::FLOAT64) {
+                        metric.reducedMany(queries.rowData(q), chunk.rowData(begin), count, dims,
+                                           block);
+                    } else if (precision == Precision::FLOAT32) {
+                        metric.reducedMany(queryFloats + q * dims, chunkFloats + begin * dims,
+                                           count, dims, floatBlock);
+                        std::copy(floatBlock, floatBlock + count, block);
+                    } else {
+                        // Float32 rows, distances accumulated in double
+                        for (size_t r = 0; r < count; r++) {
+                            block[r] = MetricPolicy::reducedAs<double>(
+                                metric, queries.rowData(q), chunkFloats + (begin + r) * dims, dims);
+                        }
+                    }
+                    for (size_t r = 0; r < count; r++) {
+                        nearest[q].push(block[r], {static_cast<int>(firstIndex + begin + r),
+                                                   chunk.label(begin + r)});
+                    }
+                }
+            }
+        });
+    });
 }
 
-int KNNBasic::predict(const Point& query) {
-    auto neighbors = findKNearest(query);
+std::vector<KNNBasic::CandidateSet> KNNBasic::searchBatch(const Dataset& queries, int numThreads,
+                                                          size_t& rows) const {
+    if (!isStreaming() && trainingData.empty()) {
+        throw std::runtime_error("No training data. Call fit() first.");
+    }
+    size_t dims = trainingDimensions();
+    if (!queries.empty() && queries.dimensions() != dims) {
+        throw std::invalid_argument("Query dimension does not match training data");
+    }
 
-    // Count votes for each label
-    std::map<int, int> votes;
-    for (const auto& neighbor : neighbors) {
-        votes[neighbor.label]++;
+    std::vector<CandidateSet> nearest(queries.size(), CandidateSet(k));
+    AlignedVector<float> queryFloats;
+    if (precision == Precision::FLOAT32) {
+        queryFloats.assign(queries.data(), queries.data() + queries.size() * dims);
     }
 
-    // Find label with most votes
-    int predictedLabel = -1;
-    int maxVotes = 0;
-    for (const auto& [label, count] : votes) {
-        if (count > maxVotes) {
-            maxVotes = count;
-            predictedLabel = label;
+    if (!isStreaming()) {
+        scanChunk(trainingData, floatRows.data(), 0, queries, queryFloats.data(), nearest,
+                  numThreads);
+        rows = trainingData.size();
+    } else {
+        // One pass over the file: a chunk is scored against every query
+        // before the next one is read, so memory is bounded by the chunk size
+        CSVChunkReader reader(streamPath, streamChunkRows, streamHeader, streamLabelColumn);
+        Dataset chunk;
+        AlignedVector<float> chunkFloats;
+        rows = 0;
+        while (reader.next(chunk)) {
+            if (chunk.dimensions() != dims) {
+                throw std::runtime_error("Training file changed: " + streamPath);
+            }
+            if (precision != Precision::FLOAT64) {
+                chunkFloats.assign(chunk.data(), chunk.data() + chunk.size() * dims);
+            }
+            scanChunk(chunk, chunkFloats.data(), rows, queries, queryFloats.data(), nearest,
+                      numThreads);
+            rows += chunk.size();
         }
     }
+    DistanceMetrics::distance_calculation_counter.fetch_add(
+        static_cast<long long>(rows * queries.size()));
 
-    return predictedLabel;
+    return nearest;
 }
 
-KNNBasic::PredictionResult KNNBasic::predictWithMetrics(const Point& query) {
-    auto start = std::chrono::high_resolution_clock::now();
+std::vector<std::vector<Neighbor>> KNNBasic::findKNearestIndicesBatch(const Dataset& queries,
+                                                                      int numThreads) {
+    size_t rows;
+    std::vector<CandidateSet> nearest = searchBatch(queries, numThreads, rows);
+
+    std::vector<std::vector<Neighbor>> results(nearest.size());
+    MetricPolicy::withMetric(distanceMetric, minkowskiP, [&](const auto& metric) {
+        for (size_t q = 0; q < nearest.size(); q++) {
+            for (const auto& entry : nearest[q].sorted()) {
+                results[q].push_back({entry.id.index, metric.toDistance(entry.distance)});
+            }
+        }
+    });
+    return results;
+}
+
+std::vector<int> KNNBasic::predictBatch(const Dataset& queries, int numThreads) {
+    size_t rows;
+    std::vector<CandidateSet> nearest = searchBatch(queries, numThreads, rows);
+
+    std::vector<int> predictions;
+    predictions.reserve(nearest.size());
+    std::vector<int> labels;
+    for (const auto& candidates : nearest) {
+        labels.clear();
+        for (const auto& entry : candidates.sorted()) {
+            labels.push_back(entry.id.label);
+        }
+        predictions.push_back(majorityVote(labels));
+    }
+    return predictions;
+}
 
+std::vector<Neighbor> KNNBasic::findKNearestIndices(RowView query) {
+    if (isStreaming()) {
+        if (query.dimensions() != streamDims) {
+            throw std::invalid_argument("Query dimension does not match training data");
+        }
+        Dataset queries(streamDims);
+        queries.addRow(query.data, -1);
+        return findKNearestIndicesBatch(queries, 1).front();
+    }
     if (trainingData.empty()) {
         throw std::runtime_error("No training data. Call fit() first.");
     }
+    if (query.dimensions() != trainingData.dimensions()) {
+        throw std::invalid_argument("Query dimension does not match training data");
+    }
 
     // Calculate distances for all training points
-    std::vector<std::pair<double, Point>> distances;
-    distances.reserve(trainingData.size());
+    // Blocks of rows go through the one-to-many kernel and stream into a
+    // bounded top-k set (O(n log k), only indices kept). Ranking by reduced
+    // distance (e.g. squared L2) gives the same order, so only the k results
+    // are converted back.
+    size_t n = trainingData.size();
+    size_t dims = trainingData.dimensions();
+    KNearestSet<int> nearest(k);
 
-    int distance_calculations = 0;
-    for (const auto& point : trainingData) {
-        double dist = calculateDistance(query, point);
-        distances.push_back({dist, point});
-        distance_calculations++;
-    }
+    std::vector<Neighbor> neighbors;
+
+    // The metric is resolved once; the scan is instantiated per metric policy
+    MetricPolicy::withMetric(distanceMetric, minkowskiP, [&](const auto& metric) {
+        if (precision == Precision::FLOAT64) {
+            double block[BLOCK_ROWS];
+            for (size_t begin = 0; begin < n; begin += BLOCK_ROWS) {
+                size_t count = std::min(BLOCK_ROWS, n - begin);
+                metric.reducedMany(query.data, trainingData.rowData(begin), count, dims, block);
+                for (size_t r = 0; r < count; r++) {
+                    nearest.push(block[r], static_cast<int>(begin + r));
+                }
+            }
+        } else if (precision == Precision::FLOAT32) {
+            std::vector<float> floatQuery(query.data, query.data + dims);
+            float block[BLOCK_ROWS];
+            for (size_t begin = 0; begin < n; begin += BLOCK_ROWS) {
+                size_t count = std::min(BLOCK_ROWS, n - begin);
+                metric.reducedMany(floatQuery.data(), floatRows.data() + begin * dims, count, dims,
+                                   block);
+                for (size_t r = 0; r < count; r++) {
+                    nearest.push(block[r], static_cast<int>(begin + r));
+                }
+            }
+        } else {
+            // Float32 rows, distances accumulated in double
+            for (size_t i = 0; i < n; i++) {
+                nearest.push(MetricPolicy::reducedAs<double>(metric, query.data,
+                                                             floatRows.data() + i * dims, dims),
+                             static_cast<int>(i));
+            }
+        }
 
-    // Sort by distance
-    std::sort(distances.begin(), distances.end(),
-              [](const auto& a, const auto& b) { return a.first < b.first; });
+        // Get k nearest neighbors, nearest first
+        neighbors.reserve(nearest.size());
+        for (const auto& entry : nearest.sorted()) {
+            neighbors.push_back({entry.id, metric.toDistance(entry.distance)});
+        }
+    });
+    DistanceMetrics::distance_calculation_counter.fetch_add(static_cast<long long>(n));
 
-    // Get k nearest neighbors
+    return neighbors;
+}
+
+std::vector<Point> KNNBasic::findKNearest(const Point& query) {
+    if (isStreaming()) {
+        throw std::runtime_error("findKNearest() needs in-memory training data");
+    }
     std::vector<Point> neighbors;
-    int limit = std::min(k, static_cast<int>(distances.size()));
-    neighbors.reserve(limit);
+    for (const auto& neighbor : findKNearestIndices(query)) {
+        neighbors.push_back(trainingData.row(neighbor.index).toPoint());
+    }
+    return neighbors;
+}
 
-    for (int i = 0; i < limit; i++) {
-        neighbors.push_back(distances[i].second);
+int KNNBasic::majorityVote(const std::vector<Neighbor>& neighbors) const {
+    std::vector<int> labels;
+    labels.reserve(neighbors.size());
+    for (const auto& neighbor : neighbors) {
+        labels.push_back(trainingData.label(neighbor.index));
     }
+    return majorityVote(labels);
+}
 
+int KNNBasic::majorityVote(const std::vector<int>& labels) {
     // Count votes for each label
     std::map<int, int> votes;
-    for (const auto& neighbor : neighbors) {
-        votes[neighbor.label]++;
+    for (int label : labels) {
+        votes[label]++;
     }
 
     // Find label with most votes
@@ -129,6 +276,45 @@ KNNBasic::PredictionResult KNNBasic::predictWithMetrics(const Point& query) {
         }
     }
 
+    return predictedLabel;
+}
+
+int KNNBasic::predict(RowView query) {
+    if (isStreaming()) {
+        return predictWithMetrics(query).predicted_label;
+    }
+    return majorityVote(findKNearestIndices(query));
+}
+
+KNNBasic::PredictionResult KNNBasic::predictWithMetrics(RowView query) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    int distance_calculations;
+    int predictedLabel;
+    if (isStreaming()) {
+        // Labels travel with the candidates; the file is not kept in memory
+        if (query.dimensions() != streamDims) {
+            throw std::invalid_argument("Query dimension does not match training data");
+        }
+        Dataset queries(streamDims);
+        queries.addRow(query.data, -1);
+        size_t rows;
+        std::vector<int> labels;
+        for (const auto& entry : searchBatch(queries, 1, rows).front().sorted()) {
+            labels.push_back(entry.id.label);
+        }
+        distance_calculations = static_cast<int>(rows);
+        predictedLabel = majorityVote(labels);
+    } else {
+        if (trainingData.empty()) {
+            throw std::runtime_error("No training data. Call fit() first.");
+        }
+
+        // Neighbors are found once; the scan computes one distance per training point
+        distance_calculations = static_cast<int>(trainingData.size());
+        predictedLabel = majorityVote(findKNearestIndices(query));
+    }
+
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     double time_ms = duration.count() / 1000.0;
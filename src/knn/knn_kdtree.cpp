@@ -1,58 +1,98 @@
 #include "../../include/knn/knn_kdtree.h"
+#include <algorithm>
 #include <map>
 #include <stdexcept>
 #include <chrono>
 
-KNNKDTree::KNNKDTree(int k_neighbors, int dims, DistanceType metric, double p)
+KNNKDTree::KNNKDTree(int k_neighbors, int dims, DistanceType metric, double p, int leafSize,
+                     Precision precision, SplitRule splitRule)
     : tree(nullptr), k(k_neighbors), dimensions(dims),
-      distanceMetric(metric), minkowskiP(p) {
+      distanceMetric(metric), minkowskiP(p), leafSize(leafSize) {
     if (k <= 0) {
         throw std::invalid_argument("k must be positive");
     }
     if (dims <= 0) {
         throw std::invalid_argument("dimensions must be positive");
     }
+    if (leafSize <= 0) {
+        throw std::invalid_argument("leafSize must be positive");
+    }
 
-    tree = new KDTree(dims, metric, p);
+    tree = new KDTree(dims, metric, p, leafSize, precision, splitRule);
 }
 
 KNNKDTree::~KNNKDTree() {
     delete tree;
 }
 
-void KNNKDTree::fit(const std::vector<Point>& data) {
+void KNNKDTree::fit(const std::vector<Point>& data, int numThreads) {
     if (data.empty()) {
         throw std::invalid_argument("Training data cannot be empty");
     }
 
-    trainingData = data;
+    fit(Dataset::fromPoints(data), numThreads);
+}
 
-    // Build k-d tree from training data
-    for (const auto& point : data) {
-        tree->insert(point);
+void KNNKDTree::fit(const Dataset& data, int numThreads) {
+    if (data.empty()) {
+        throw std::invalid_argument("Training data cannot be empty");
     }
+    if (data.dimensions() != static_cast<size_t>(dimensions)) {
+        throw std::invalid_argument("Training data dimension does not match");
+    }
+
+    trainingData = data;
+
+    // Build a balanced k-d tree from training data in one pass
+    tree->build(trainingData, numThreads);
 }
 
-std::vector<Point> KNNKDTree::findKNearest(const Point& query) {
-    if (trainingData.empty()) {
+void KNNKDTree::checkQuery(size_t queryDims) const {
+    if (!tree->hasIndex()) {
         throw std::runtime_error("No training data. Call fit() first.");
     }
+    if (queryDims != static_cast<size_t>(dimensions)) {
+        throw std::invalid_argument("Query dimension does not match training data");
+    }
+}
+
+std::vector<Point> KNNKDTree::findKNearest(const Point& query) {
+    checkQuery(query.dimensions());
 
     // Use k-d tree's k-nearest neighbors search
     return tree->kNearestNeighbors(query, k);
 }
 
-int KNNKDTree::predict(const Point& query) {
-    auto neighbors = findKNearest(query);
+std::vector<Neighbor> KNNKDTree::findKNearestIndices(RowView query) {
+    checkQuery(query.dimensions());
+
+    return tree->kNearestNeighborIndices(query, k);
+}
 
+void KNNKDTree::save(const std::string& path) const {
+    tree->save(path);
+}
+
+std::unique_ptr<KNNKDTree> KNNKDTree::load(const std::string& path, int k_neighbors) {
+    std::unique_ptr<KDTree> index = KDTree::load(path);
+    auto model = std::make_unique<KNNKDTree>(k_neighbors, index->getDimensions(),
+                                             index->getDistanceMetric(), index->getMinkowskiP(),
+                                             index->getLeafSize(), index->getPrecision(),
+                                             index->getSplitRule());
+    delete model->tree;
+    model->tree = index.release();
+    return model;
+}
+
+int KNNKDTree::majorityVote(const std::vector<Neighbor>& neighbors) const {
     if (neighbors.empty()) {
         return -1;
     }
 
-    // Count votes for each label
+    // Count votes for each label, read straight from the index
     std::map<int, int> votes;
     for (const auto& neighbor : neighbors) {
-        votes[neighbor.label]++;
+        votes[tree->labelOf(neighbor.index)]++;
     }
 
     // Find label with most votes
@@ -68,21 +108,83 @@ int KNNKDTree::predict(const Point& query) {
     return predictedLabel;
 }
 
-KNNKDTree::PredictionResult KNNKDTree::predictWithMetrics(const Point& query) {
-    auto start = std::chrono::high_resolution_clock::now();
+int KNNKDTree::predict(RowView query) {
+    return majorityVote(findKNearestIndices(query));
+}
 
-    if (trainingData.empty()) {
+std::vector<std::vector<Point>> KNNKDTree::findKNearestBatch(const std::vector<Point>& queries,
+                                                             int numThreads) {
+    if (!tree->hasIndex()) {
         throw std::runtime_error("No training data. Call fit() first.");
     }
 
-    // Reset distance counter before search
-    tree->resetDistanceCount();
+    return tree->kNearestNeighborsBatch(queries, k, numThreads);
+}
 
-    // Use k-d tree's k-nearest neighbors search
-    auto neighbors = tree->kNearestNeighbors(query, k);
+std::vector<std::vector<Neighbor>> KNNKDTree::findKNearestIndicesBatch(
+    const std::vector<Point>& queries, int numThreads) {
+    if (!tree->hasIndex()) {
+        throw std::runtime_error("No training data. Call fit() first.");
+    }
+
+    return tree->kNearestNeighborIndicesBatch(queries, k, numThreads);
+}
+
+std::vector<std::vector<Neighbor>> KNNKDTree::findKNearestIndicesBatch(const Dataset& queries,
+                                                                       int numThreads) {
+    if (!tree->hasIndex()) {
+        throw std::runtime_error("No training data. Call fit() first.");
+    }
+
+    return tree->kNearestNeighborIndicesBatch(queries, k, numThreads);
+}
 
-    // Get distance calculations count
-    int distance_calculations = tree->getDistanceCount();
+std::vector<int> KNNKDTree::predictBatch(const std::vector<Point>& queries, int numThreads) {
+    auto neighbors = findKNearestIndicesBatch(queries, numThreads);
+
+    std::vector<int> predictions(neighbors.size());
+    for (size_t i = 0; i < neighbors.size(); i++) {
+        predictions[i] = majorityVote(neighbors[i]);
+    }
+    return predictions;
+}
+
+std::vector<int> KNNKDTree::predictBatch(const Dataset& queries, int numThreads) {
+    auto neighbors = findKNearestIndicesBatch(queries, numThreads);
+
+    std::vector<int> predictions(neighbors.size());
+    for (size_t i = 0; i < neighbors.size(); i++) {
+        predictions[i] = majorityVote(neighbors[i]);
+    }
+    return predictions;
+}
+
+KNNKDTree::PredictionResult KNNKDTree::predictWithMetrics(RowView query) {
+    return predictWithMetrics(query, -1);
+}
+
+KNNKDTree::PredictionResult KNNKDTree::predictWithMetrics(RowView query, int excludeIndex) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    checkQuery(query.dimensions());
+
+    // Use k-d tree's k-nearest neighbors search, counting this query only;
+    // one extra neighbor stands in for an excluded point
+    long long distances = 0;
+    int searched = excludeIndex >= 0 ? k + 1 : k;
+    auto neighbors = tree->kNearestNeighborIndices(query, searched, distances);
+    int distance_calculations = static_cast<int>(distances);
+    if (excludeIndex >= 0) {
+        auto excluded = std::find_if(neighbors.begin(), neighbors.end(),
+                                     [excludeIndex](const Neighbor& neighbor) {
+                                         return neighbor.index == excludeIndex;
+                                     });
+        if (excluded != neighbors.end()) {
+            neighbors.erase(excluded);
+        } else if (neighbors.size() > static_cast<size_t>(k)) {
+            neighbors.pop_back();
+        }
+    }
 
     if (neighbors.empty()) {
         auto end = std::chrono::high_resolution_clock::now();
@@ -91,21 +193,7 @@ KNNKDTree::PredictionResult KNNKDTree::predictWithMetrics(const Point& query) {
         return {-1, distance_calculations, time_ms};
     }
 
-    // Count votes for each label
-    std::map<int, int> votes;
-    for (const auto& neighbor : neighbors) {
-        votes[neighbor.label]++;
-    }
-
-    // Find label with most votes
-    int predictedLabel = -1;
-    int maxVotes = 0;
-    for (const auto& [label, count] : votes) {
-        if (count > maxVotes) {
-            maxVotes = count;
-            predictedLabel = label;
-        }
-    }
+    int predictedLabel = majorityVote(neighbors);
 
     auto end = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
@@ -120,6 +208,16 @@ void KNNKDTree::resetDistanceCount() {
     }
 }
 
-int KNNKDTree::getDistanceCount() const {
+long long KNNKDTree::getDistanceCount() const {
     return tree ? tree->getDistanceCount() : 0;
 }
+
+void KNNKDTree::resetNodeVisitCount() {
+    if (tree) {
+        tree->resetNodeVisitCount();
+    }
+}
+
+long long KNNKDTree::getNodeVisitCount() const {
+    return tree ? tree->getNodeVisitCount() : 0;
+}
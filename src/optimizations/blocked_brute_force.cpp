@@ -0,0 +1,132 @@
+#include "../../include/optimizations/blocked_brute_force.h"
+#include "../../include/utils/distance_kernels.h"
+#include "../../include/utils/knearest_set.h"
+#include "../../include/utils/parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+BlockedBruteForce::BlockedBruteForce(int dimensions)
+    : dims(dimensions), tileRows(0), distance_calc_count(0) {
+    if (dimensions <= 0) {
+        throw std::invalid_argument("dimensions must be positive");
+    }
+
+    // About 64 KB of coordinates per tile, a multiple of 16 rows
+    tileRows = std::min<size_t>(1024, std::max<size_t>(64, 8192 / dimensions)) / 16 * 16;
+}
+
+void BlockedBruteForce::fit(const std::vector<Point>& data) {
+    for (const auto& point : data) {
+        if (point.dimensions() != static_cast<size_t>(dims)) {
+            throw std::invalid_argument("Point dimension does not match");
+        }
+    }
+
+    fit(Dataset::fromPoints(data));
+}
+
+void BlockedBruteForce::fit(const Dataset& data) {
+    if (!data.empty() && data.dimensions() != static_cast<size_t>(dims)) {
+        throw std::invalid_argument("Point dimension does not match");
+    }
+
+    trainingData = data;
+    size_t n = data.size();
+    size_t numTiles = (n + tileRows - 1) / tileRows;
+
+    // Transpose each tile; rows past the end of the last tile stay zero
+    tiles.assign(numTiles * dims * tileRows, 0.0);
+    norms.assign(n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        const double* row = data.rowData(i);
+        size_t t = i / tileRows;
+        size_t j = i % tileRows;
+        double norm = 0;
+        for (int d = 0; d < dims; d++) {
+            tiles[(t * dims + d) * tileRows + j] = row[d];
+            norm += row[d] * row[d];
+        }
+        norms[i] = norm;
+    }
+}
+
+std::vector<std::vector<Neighbor>> BlockedBruteForce::kNearestNeighborsBatch(
+    const Dataset& queries, int k, int numThreads) const {
+    std::vector<std::vector<Neighbor>> results(queries.size());
+    if (k <= 0 || trainingData.empty() || queries.empty()) {
+        return results;
+    }
+    if (queries.dimensions() != static_cast<size_t>(dims)) {
+        throw std::invalid_argument("Query dimension does not match");
+    }
+
+    size_t n = trainingData.size();
+    size_t numTiles = (n + tileRows - 1) / tileRows;
+
+    Parallel::forEachChunk(queries.size(), numThreads,
+        [&](size_t begin, size_t end, int) {
+            size_t count = end - begin;
+            std::vector<KNearestSet<int>> candidates;
+            candidates.reserve(count);
+            std::vector<double> queryNorms(count);
+            for (size_t i = 0; i < count; i++) {
+                candidates.emplace_back(k);
+                const double* q = queries.rowData(begin + i);
+                for (int d = 0; d < dims; d++) {
+                    queryNorms[i] += q[d] * q[d];
+                }
+            }
+
+            // Groups of DOT_QUERIES queries; a short last group is padded
+            // with a zero query whose products are ignored
+            const size_t group = DistanceKernels::DOT_QUERIES;
+            std::vector<double> zeros(dims, 0.0);
+            AlignedVector<double> dot(group * tileRows);
+            for (size_t t = 0; t < numTiles; t++) {
+                size_t base = t * tileRows;
+                size_t rows = std::min(tileRows, n - base);
+
+                // The tile stays in cache while every query of the block uses it
+                for (size_t g = 0; g < count; g += group) {
+                    const double* q[group];
+                    for (size_t i = 0; i < group; i++) {
+                        q[i] = g + i < count ? queries.rowData(begin + g + i) : zeros.data();
+                    }
+                    DistanceKernels::dotProducts(q, tileColumn(t, 0), tileRows, dims, dot.data(), rows);
+
+                    for (size_t i = 0; i < group && g + i < count; i++) {
+                        KNearestSet<int>& found = candidates[g + i];
+                        double qn = queryNorms[g + i];
+                        const double* products = dot.data() + i * rows;
+                        for (size_t j = 0; j < rows; j++) {
+                            // Rounding can push an exact match slightly below zero
+                            double dist = std::max(0.0, qn + norms[base + j] - 2.0 * products[j]);
+                            found.push(dist, static_cast<int>(base + j));
+                        }
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < count; i++) {
+                auto& out = results[begin + i];
+                for (const auto& entry : candidates[i].sorted()) {
+                    out.push_back({entry.id, std::sqrt(entry.distance)});
+                }
+            }
+        }, QUERY_TILE);
+
+    distance_calc_count += static_cast<long long>(queries.size()) * static_cast<long long>(n);
+    return results;
+}
+
+std::vector<std::vector<Neighbor>> BlockedBruteForce::kNearestNeighborsBatch(
+    const std::vector<Point>& queries, int k, int numThreads) const {
+    for (const auto& query : queries) {
+        if (query.dimensions() != static_cast<size_t>(dims)) {
+            throw std::invalid_argument("Query dimension does not match");
+        }
+    }
+
+    return kNearestNeighborsBatch(Dataset::fromPoints(queries), k, numThreads);
+}
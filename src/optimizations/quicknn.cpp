@@ -0,0 +1,286 @@
+#include "../../include/optimizations/quicknn.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+
+// Counting sort of items by key: items of key b end up in
+// sorted[start[b], start[b + 1])
+void groupByKey(const std::vector<int>& keys, const std::vector<int>& items, int numKeys,
+                std::vector<int>& start, std::vector<int>& sorted) {
+    start.assign(numKeys + 1, 0);
+    for (int key : keys) {
+        start[key + 1]++;
+    }
+    for (int b = 0; b < numKeys; b++) {
+        start[b + 1] += start[b];
+    }
+
+    std::vector<int> fill(start.begin(), start.end() - 1);
+    sorted.resize(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        sorted[fill[keys[i]]++] = items[i];
+    }
+}
+
+} // namespace
+
+QuickNN::QuickNN(int dimensions, int leafSize)
+    : k(dimensions), leafSize(leafSize), distance_calc_count(0) {
+    if (dimensions <= 0) {
+        throw std::invalid_argument("dimensions must be positive");
+    }
+    if (leafSize <= 0) {
+        throw std::invalid_argument("leafSize must be positive");
+    }
+}
+
+void QuickNN::fit(const std::vector<Point>& data) {
+    for (const auto& point : data) {
+        if (point.dimensions() != static_cast<size_t>(k)) {
+            throw std::invalid_argument("Point dimension does not match");
+        }
+    }
+
+    nodes.clear();
+    bucketOffsets.clear();
+    bucketLower.clear();
+    bucketUpper.clear();
+
+    size_t n = data.size();
+    points.resize(n * k);
+    labels.resize(n);
+    if (n == 0) return;
+
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    buildRec(order, data, 0, static_cast<int>(n));
+    bucketOffsets.push_back(static_cast<int>(n));
+
+    // Buckets are laid out in tree order, each one contiguous
+    for (size_t i = 0; i < n; i++) {
+        const Point& point = data[order[i]];
+        std::copy(point.coordinates.begin(), point.coordinates.end(), points.begin() + i * k);
+        labels[i] = point.label;
+    }
+}
+
+// Median split on the dimension of widest spread
+int QuickNN::buildRec(std::vector<int>& order, const std::vector<Point>& data, int begin, int end) {
+    int i = static_cast<int>(nodes.size());
+    nodes.push_back({0.0, -1, -1});
+
+    std::vector<double> lo(data[order[begin]].coordinates);
+    std::vector<double> hi(lo);
+    for (int j = begin + 1; j < end; j++) {
+        const Point& point = data[order[j]];
+        for (int d = 0; d < k; d++) {
+            lo[d] = std::min(lo[d], point[d]);
+            hi[d] = std::max(hi[d], point[d]);
+        }
+    }
+
+    int disc = 0;
+    for (int d = 1; d < k; d++) {
+        if (hi[d] - lo[d] > hi[disc] - lo[disc]) disc = d;
+    }
+
+    // Small buckets and sets of identical points become leaves
+    if (end - begin <= leafSize || hi[disc] == lo[disc]) {
+        nodes[i].next = static_cast<int>(bucketOffsets.size());
+        bucketOffsets.push_back(begin);
+        bucketLower.insert(bucketLower.end(), lo.begin(), lo.end());
+        bucketUpper.insert(bucketUpper.end(), hi.begin(), hi.end());
+        return i;
+    }
+
+    int mid = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [&data, disc](int a, int b) { return data[a][disc] < data[b][disc]; });
+
+    nodes[i].disc = disc;
+    nodes[i].split = data[order[mid]][disc];
+    buildRec(order, data, begin, mid);
+    int hison = buildRec(order, data, mid, end);
+    nodes[i].next = hison;
+    return i;
+}
+
+Point QuickNN::pointAt(int i) const {
+    return Point(std::vector<double>(row(i), row(i) + k), labels[i]);
+}
+
+int QuickNN::homeBucket(const double* q) const {
+    int i = 0;
+    while (nodes[i].disc != -1) {
+        i = (q[nodes[i].disc] < nodes[i].split) ? i + 1 : nodes[i].next;
+    }
+    return nodes[i].next;
+}
+
+// Squared distance from q to the bucket's bounding box
+double QuickNN::bucketLowerBound(int bucket, const double* q) const {
+    const double* lo = bucketLower.data() + static_cast<size_t>(bucket) * k;
+    const double* hi = bucketUpper.data() + static_cast<size_t>(bucket) * k;
+    double bound = 0;
+    for (int d = 0; d < k; d++) {
+        double gap = std::max({lo[d] - q[d], q[d] - hi[d], 0.0});
+        bound += gap * gap;
+    }
+    return bound;
+}
+
+void QuickNN::scanBucket(int bucket, const double* q, KNearestSet<int>& candidates) const {
+    int begin = bucketOffsets[bucket];
+    int end = bucketOffsets[bucket + 1];
+    distance_calc_count += end - begin;  // Track distance calculations
+
+    if (k == 3) {
+        // Point cloud fast path: fixed stride, no inner loop
+        const double* x = row(begin);
+        for (int j = begin; j < end; j++, x += 3) {
+            double dx = q[0] - x[0];
+            double dy = q[1] - x[1];
+            double dz = q[2] - x[2];
+            candidates.push(dx * dx + dy * dy + dz * dz, j);
+        }
+        return;
+    }
+
+    for (int j = begin; j < end; j++) {
+        const double* x = row(j);
+        double sum = 0;
+        for (int d = 0; d < k; d++) {
+            double diff = q[d] - x[d];
+            sum += diff * diff;
+        }
+        candidates.push(sum, j);
+    }
+}
+
+void QuickNN::kNearestRec(int node, const double* q, double rd, std::vector<double>& offsets,
+                          int home, KNearestSet<int>& candidates) const {
+    const Node& current = nodes[node];
+    if (current.disc == -1) {
+        // Tight bucket box is usually well inside the cell
+        if (current.next != home && bucketLowerBound(current.next, q) < candidates.worst()) {
+            scanBucket(current.next, q, candidates);
+        }
+        return;
+    }
+
+    int d = current.disc;
+    double diff = q[d] - current.split;
+    int nearer = (diff < 0) ? node + 1 : current.next;
+    int further = (diff < 0) ? current.next : node + 1;
+
+    kNearestRec(nearer, q, rd, offsets, home, candidates);
+
+    double old = offsets[d];
+    double farRd = rd - old * old + diff * diff;
+    if (farRd < candidates.worst()) {
+        offsets[d] = diff;
+        kNearestRec(further, q, farRd, offsets, home, candidates);
+        offsets[d] = old;
+    }
+}
+
+Point QuickNN::nearestNeighbor(const Point& target) const {
+    auto result = kNearestNeighbors(target, 1);
+    return result.empty() ? Point() : result.front();
+}
+
+std::vector<Point> QuickNN::kNearestNeighbors(const Point& target, int k) const {
+    if (nodes.empty() || k <= 0) {
+        return {};
+    }
+    if (target.dimensions() != static_cast<size_t>(this->k)) {
+        throw std::invalid_argument("Query dimension does not match");
+    }
+
+    const double* q = target.coordinates.data();
+    KNearestSet<int> candidates(k);
+    int home = homeBucket(q);
+    scanBucket(home, q, candidates);
+
+    std::vector<double> offsets(this->k, 0.0);
+    kNearestRec(0, q, 0.0, offsets, home, candidates);
+
+    std::vector<Point> result;
+    result.reserve(candidates.size());
+    for (const auto& candidate : candidates.sorted()) {
+        result.push_back(pointAt(candidate.id));
+    }
+    return result;
+}
+
+std::vector<std::vector<Point>> QuickNN::kNearestNeighborsBatch(const std::vector<Point>& queries,
+                                                                int k) const {
+    std::vector<std::vector<Point>> results(queries.size());
+    if (nodes.empty() || k <= 0 || queries.empty()) {
+        return results;
+    }
+
+    for (const auto& query : queries) {
+        if (query.dimensions() != static_cast<size_t>(this->k)) {
+            throw std::invalid_argument("Query dimension does not match");
+        }
+    }
+
+    int numQueries = static_cast<int>(queries.size());
+    int numBuckets = static_cast<int>(bucketCount());
+
+    // Route every query to its home bucket
+    std::vector<int> home(numQueries);
+    std::vector<int> ids(numQueries);
+    for (int i = 0; i < numQueries; i++) {
+        home[i] = homeBucket(queries[i].coordinates.data());
+        ids[i] = i;
+    }
+
+    // Group queries by home bucket; grouped queries are copied into one
+    // contiguous block so per-query state is walked sequentially
+    std::vector<int> start;
+    std::vector<int> grouped;
+    groupByKey(home, ids, numBuckets, start, grouped);
+
+    AlignedVector<double> block(static_cast<size_t>(numQueries) * this->k);
+    for (int j = 0; j < numQueries; j++) {
+        const auto& coordinates = queries[grouped[j]].coordinates;
+        std::copy(coordinates.begin(), coordinates.end(), block.begin() + static_cast<size_t>(j) * this->k);
+    }
+
+    std::vector<KNearestSet<int>> candidates;
+    candidates.reserve(numQueries);
+    for (int j = 0; j < numQueries; j++) {
+        candidates.emplace_back(k);
+    }
+
+    // Stream each bucket once for all queries landing in it
+    for (int b = 0; b < numBuckets; b++) {
+        for (int j = start[b]; j < start[b + 1]; j++) {
+            scanBucket(b, block.data() + static_cast<size_t>(j) * this->k, candidates[j]);
+        }
+    }
+
+    // Finish each query; neighboring queries share most of their tree paths
+    // and buckets, so these stay in cache from one query to the next
+    std::vector<double> offsets(this->k, 0.0);
+    for (int b = 0; b < numBuckets; b++) {
+        for (int j = start[b]; j < start[b + 1]; j++) {
+            kNearestRec(0, block.data() + static_cast<size_t>(j) * this->k, 0.0, offsets, b, candidates[j]);
+        }
+    }
+
+    // Results back in input order
+    for (int j = 0; j < numQueries; j++) {
+        auto& result = results[grouped[j]];
+        auto sorted = candidates[j].sorted();
+        result.reserve(sorted.size());
+        for (const auto& candidate : sorted) {
+            result.push_back(pointAt(candidate.id));
+        }
+    }
+    return results;
+}
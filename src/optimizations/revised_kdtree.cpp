@@ -0,0 +1,265 @@
+#include "../../include/optimizations/revised_kdtree.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+RevisedKDTree::RevisedKDTree(int dimensions, DistanceType metric, double p, int leafSize)
+    : k(dimensions), distanceMetric(metric), minkowskiP(p), leafSize(leafSize),
+      useTriangleInequality(metric != DistanceType::MINKOWSKI || p >= 1.0),
+      distance_calc_count(0) {
+    if (dimensions <= 0) {
+        throw std::invalid_argument("dimensions must be positive");
+    }
+    if (leafSize <= 0) {
+        throw std::invalid_argument("leafSize must be positive");
+    }
+}
+
+void RevisedKDTree::fit(const std::vector<Point>& data) {
+    for (const auto& point : data) {
+        if (point.dimensions() != static_cast<size_t>(k)) {
+            throw std::invalid_argument("Point dimension does not match");
+        }
+    }
+
+    nodes.clear();
+    lower.clear();
+    upper.clear();
+    pivotOf.clear();
+    pivots.clear();
+
+    size_t n = data.size();
+    points.resize(n * k);
+    labels.resize(n);
+    pivotDistance.resize(n);
+    if (n == 0) return;
+
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    buildRec(order, data, 0, static_cast<int>(n));
+
+    // Store points in tree order, so every node's descendants are [begin, end)
+    for (size_t i = 0; i < n; i++) {
+        const Point& point = data[order[i]];
+        std::copy(point.coordinates.begin(), point.coordinates.end(), points.begin() + i * k);
+        labels[i] = point.label;
+    }
+
+    pivotOf.assign(nodes.size(), -1);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].disc == -1) {
+            buildLeaf(static_cast<int>(i));
+        }
+    }
+}
+
+// Median split on the widest side of the node's bounding box
+int RevisedKDTree::buildRec(std::vector<int>& order, const std::vector<Point>& data,
+                            int begin, int end) {
+    int i = static_cast<int>(nodes.size());
+    nodes.push_back({0.0, -1, -1, begin, end});
+
+    // Tight bounding box of the node's points
+    lower.insert(lower.end(), data[order[begin]].coordinates.begin(), data[order[begin]].coordinates.end());
+    upper.insert(upper.end(), data[order[begin]].coordinates.begin(), data[order[begin]].coordinates.end());
+    double* lo = lower.data() + static_cast<size_t>(i) * k;
+    double* hi = upper.data() + static_cast<size_t>(i) * k;
+    for (int j = begin + 1; j < end; j++) {
+        const Point& point = data[order[j]];
+        for (int d = 0; d < k; d++) {
+            lo[d] = std::min(lo[d], point[d]);
+            hi[d] = std::max(hi[d], point[d]);
+        }
+    }
+
+    int disc = 0;
+    for (int d = 1; d < k; d++) {
+        if (hi[d] - lo[d] > hi[disc] - lo[disc]) disc = d;
+    }
+
+    // Small buckets and sets of identical points become leaves
+    if (end - begin <= leafSize || hi[disc] == lo[disc]) {
+        return i;
+    }
+
+    int mid = begin + (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+                     [&data, disc](int a, int b) { return data[a][disc] < data[b][disc]; });
+
+    nodes[i].disc = disc;
+    nodes[i].split = data[order[mid]][disc];
+    buildRec(order, data, begin, mid);
+    int hison = buildRec(order, data, mid, end);
+    nodes[i].hison = hison;
+    return i;
+}
+
+// Leaf pivot is the bucket centroid; each point remembers its distance to it
+void RevisedKDTree::buildLeaf(int node) {
+    const Node& leaf = nodes[node];
+    int count = leaf.end - leaf.begin;
+
+    pivotOf[node] = static_cast<int>(pivots.size() / k);
+    pivots.resize(pivots.size() + k, 0.0);
+    double* pivot = pivots.data() + pivots.size() - k;
+
+    for (int j = leaf.begin; j < leaf.end; j++) {
+        for (int d = 0; d < k; d++) {
+            pivot[d] += row(j)[d] / count;
+        }
+    }
+    for (int j = leaf.begin; j < leaf.end; j++) {
+        pivotDistance[j] = DistanceMetrics::reducedToDistance(
+            DistanceMetrics::reducedDistance(row(j), pivot, k, distanceMetric, minkowskiP),
+            distanceMetric, minkowskiP);
+    }
+}
+
+double RevisedKDTree::reduced(const Point& target, const double* x) const {
+    distance_calc_count++;  // Track distance calculations
+    return DistanceMetrics::reducedDistance(target.coordinates.data(), x, k,
+                                            distanceMetric, minkowskiP);
+}
+
+// Reduced distance from target to the closest point of the node's box
+double RevisedKDTree::boxLowerBound(int node, const Point& target) const {
+    const double* lo = lower.data() + static_cast<size_t>(node) * k;
+    const double* hi = upper.data() + static_cast<size_t>(node) * k;
+    double bound = 0;
+    for (int d = 0; d < k; d++) {
+        double gap = std::max({lo[d] - target[d], target[d] - hi[d], 0.0});
+        bound = DistanceMetrics::combineAxisDistances(
+            bound, DistanceMetrics::reducedAxisDistance(gap, distanceMetric, minkowskiP),
+            distanceMetric);
+    }
+    return bound;
+}
+
+// Reduced distance from target to the farthest point of the node's box
+double RevisedKDTree::boxUpperBound(int node, const Point& target) const {
+    const double* lo = lower.data() + static_cast<size_t>(node) * k;
+    const double* hi = upper.data() + static_cast<size_t>(node) * k;
+    double bound = 0;
+    for (int d = 0; d < k; d++) {
+        double gap = std::max(std::abs(target[d] - lo[d]), std::abs(target[d] - hi[d]));
+        bound = DistanceMetrics::combineAxisDistances(
+            bound, DistanceMetrics::reducedAxisDistance(gap, distanceMetric, minkowskiP),
+            distanceMetric);
+    }
+    return bound;
+}
+
+Point RevisedKDTree::pointAt(int i) const {
+    return Point(std::vector<double>(row(i), row(i) + k), labels[i]);
+}
+
+void RevisedKDTree::kNearestRec(int node, const Point& target, double lowerBound,
+                                KNearestSet<int>& candidates) const {
+    if (!(lowerBound < candidates.worst())) return;
+
+    const Node& current = nodes[node];
+
+    if (current.disc == -1) {
+        const double* pivot = pivots.data() + static_cast<size_t>(pivotOf[node]) * k;
+        bool filter = false;
+        double pivotDist = 0;
+
+        for (int j = current.begin; j < current.end; j++) {
+            // Triangle inequality: |d(q, pivot) - d(x, pivot)| <= d(q, x)
+            if (useTriangleInequality && candidates.full()) {
+                if (!filter) {
+                    pivotDist = DistanceMetrics::reducedToDistance(
+                        reduced(target, pivot), distanceMetric, minkowskiP);
+                    filter = true;
+                }
+                double bound = std::abs(pivotDist - pivotDistance[j]);
+                if (DistanceMetrics::distanceToReduced(bound, distanceMetric, minkowskiP)
+                        >= candidates.worst()) {
+                    continue;
+                }
+            }
+            candidates.push(reduced(target, row(j)), j);
+        }
+        return;
+    }
+
+    // Visit the child whose box is nearer first
+    int left = node + 1;
+    int right = current.hison;
+    double leftBound = boxLowerBound(left, target);
+    double rightBound = boxLowerBound(right, target);
+
+    if (leftBound <= rightBound) {
+        kNearestRec(left, target, leftBound, candidates);
+        kNearestRec(right, target, rightBound, candidates);
+    } else {
+        kNearestRec(right, target, rightBound, candidates);
+        kNearestRec(left, target, leftBound, candidates);
+    }
+}
+
+void RevisedKDTree::rangeRec(int node, const Point& target, double reducedRadius,
+                             std::vector<int>& result) const {
+    // Cell outside the neighborhood: nothing to report
+    if (boxLowerBound(node, target) > reducedRadius) return;
+
+    const Node& current = nodes[node];
+
+    // Cell inside the neighborhood: report saved descendants, no distances needed
+    if (boxUpperBound(node, target) <= reducedRadius) {
+        for (int j = current.begin; j < current.end; j++) {
+            result.push_back(j);
+        }
+        return;
+    }
+
+    if (current.disc == -1) {
+        for (int j = current.begin; j < current.end; j++) {
+            if (reduced(target, row(j)) <= reducedRadius) {
+                result.push_back(j);
+            }
+        }
+        return;
+    }
+
+    rangeRec(node + 1, target, reducedRadius, result);
+    rangeRec(current.hison, target, reducedRadius, result);
+}
+
+Point RevisedKDTree::nearestNeighbor(const Point& target) const {
+    auto result = kNearestNeighbors(target, 1);
+    return result.empty() ? Point() : result.front();
+}
+
+std::vector<Point> RevisedKDTree::kNearestNeighbors(const Point& target, int k) const {
+    if (nodes.empty() || k <= 0) {
+        return {};
+    }
+
+    KNearestSet<int> candidates(k);
+    kNearestRec(0, target, boxLowerBound(0, target), candidates);
+
+    std::vector<Point> result;
+    result.reserve(candidates.size());
+    for (const auto& candidate : candidates.sorted()) {
+        result.push_back(pointAt(candidate.id));
+    }
+    return result;
+}
+
+std::vector<Point> RevisedKDTree::rangeSearch(const Point& target, double radius) const {
+    if (nodes.empty() || radius < 0) {
+        return {};
+    }
+
+    std::vector<int> indices;
+    rangeRec(0, target, DistanceMetrics::distanceToReduced(radius, distanceMetric, minkowskiP), indices);
+
+    std::vector<Point> result;
+    result.reserve(indices.size());
+    for (int i : indices) {
+        result.push_back(pointAt(i));
+    }
+    return result;
+}
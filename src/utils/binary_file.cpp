@@ -0,0 +1,55 @@
+#include "../../include/utils/binary_file.h"
+#include <algorithm>
+#include <vector>
+
+namespace BinaryFile {
+
+Preamble makePreamble(const char (&magic)[8], uint32_t version) {
+    Preamble preamble = {};
+    std::copy(magic, magic + 8, preamble.magic);
+    preamble.version = version;
+    preamble.byteOrder = BYTE_ORDER_MARK;
+    return preamble;
+}
+
+PreambleCheck checkPreamble(const Preamble& preamble, const char (&magic)[8], uint32_t version) {
+    if (!std::equal(magic, magic + 8, preamble.magic)) {
+        return PreambleCheck::WRONG_MAGIC;
+    }
+    if (preamble.byteOrder != BYTE_ORDER_MARK) {
+        return PreambleCheck::WRONG_BYTE_ORDER;
+    }
+    if (preamble.version != version) {
+        return PreambleCheck::WRONG_VERSION;
+    }
+    return PreambleCheck::OK;
+}
+
+uint64_t alignedOffset(uint64_t offset, uint64_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+SectionWriter::SectionWriter(const std::string& path, size_t headerBytes)
+    : out(path, std::ios::binary | std::ios::trunc), pos(headerBytes) {
+    // Placeholder bytes; finish() overwrites them with the header
+    std::vector<char> zeros(headerBytes, 0);
+    out.write(zeros.data(), static_cast<std::streamsize>(headerBytes));
+}
+
+uint64_t SectionWriter::write(const void* data, uint64_t bytes, uint64_t alignment) {
+    static const char zeros[SECTION_ALIGNMENT] = {};
+    uint64_t offset = alignedOffset(pos, alignment);
+    out.write(zeros, static_cast<std::streamsize>(offset - pos));
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    pos = offset + bytes;
+    return offset;
+}
+
+bool SectionWriter::finish(const void* header, size_t headerBytes) {
+    out.seekp(0);
+    out.write(static_cast<const char*>(header), static_cast<std::streamsize>(headerBytes));
+    out.close();
+    return !out.fail();
+}
+
+} // namespace BinaryFile
@@ -0,0 +1,59 @@
+#include "../../include/utils/dataset.h"
+#include <algorithm>
+#include <stdexcept>
+
+Dataset::Dataset(size_t numRows, size_t dimensions)
+    : rows(numRows), dims(dimensions), values(numRows * dimensions, 0.0),
+      rowLabels(numRows, -1) {}
+
+Dataset Dataset::fromPoints(const std::vector<Point>& points) {
+    Dataset data(points.empty() ? 0 : points.front().dimensions());
+    data.reserve(points.size());
+    for (const auto& point : points) {
+        data.addRow(point);
+    }
+    return data;
+}
+
+std::vector<Point> Dataset::toPoints() const {
+    std::vector<Point> points;
+    points.reserve(rows);
+    for (size_t i = 0; i < rows; i++) {
+        points.push_back(row(i).toPoint());
+    }
+    return points;
+}
+
+void Dataset::reserve(size_t numRows) {
+    values.reserve(numRows * dims);
+    rowLabels.reserve(numRows);
+}
+
+void Dataset::resize(size_t numRows) {
+    values.resize(numRows * dims, 0.0);
+    rowLabels.resize(numRows, -1);
+    rows = numRows;
+}
+
+void Dataset::addRow(const double* coords, int label) {
+    values.insert(values.end(), coords, coords + dims);
+    rowLabels.push_back(label);
+    rows++;
+}
+
+void Dataset::addRow(const Point& point) {
+    if (point.dimensions() != dims) {
+        throw std::invalid_argument("Point dimension does not match dataset");
+    }
+    addRow(point.coordinates.data(), point.label);
+}
+
+void Dataset::buildColumnMajor() {
+    columnValues.assign(rows * dims, 0.0);
+    for (size_t i = 0; i < rows; i++) {
+        const double* r = rowData(i);
+        for (size_t d = 0; d < dims; d++) {
+            columnValues[d * rows + i] = r[d];
+        }
+    }
+}
@@ -0,0 +1,276 @@
+#include "../../include/utils/dataset_cache.h"
+#include "../../include/utils/mapped_file.h"
+#include "../../include/utils/binary_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+// Layout of a cache file (see BinaryFile): this header, then the key, the
+// encoding, the labels and the feature columns (column d of row i at
+// columns[d * rows + i]). Labels and columns start on aligned boundaries.
+struct CacheHeader {
+    BinaryFile::Preamble preamble;
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    uint64_t sourceChecksum;    // 0 if not computed
+    uint64_t rows;
+    uint64_t dims;
+    uint64_t keyOffset;
+    uint64_t keyBytes;
+    uint64_t encodingOffset;
+    uint64_t encodingBytes;
+    uint64_t labelsOffset;
+    uint64_t columnsOffset;
+    uint64_t fileSize;
+};
+
+const char CACHE_MAGIC[8] = {'K', 'N', 'N', 'C', 'A', 'C', 'H', 'E'};
+constexpr uint32_t CACHE_VERSION = 2;
+constexpr size_t TRANSPOSE_BLOCK = 256;    // rows per block when transposing columns
+
+constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+// Encoding blob: counts as uint32, strings as uint32 length plus bytes
+void putCount(std::string& out, size_t count) {
+    uint32_t value = static_cast<uint32_t>(count);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putString(std::string& out, const std::string& text) {
+    putCount(out, text.size());
+    out += text;
+}
+
+std::string encodeBlob(const DatasetCache::Encoding& encoding) {
+    std::string out;
+    putCount(out, encoding.columns.size());
+    for (size_t c = 0; c < encoding.columns.size(); c++) {
+        putCount(out, static_cast<uint32_t>(encoding.columns[c]));
+        const auto& categories = c < encoding.categories.size() ? encoding.categories[c]
+                                                                : std::vector<std::string>();
+        putCount(out, categories.size());
+        for (const auto& category : categories) {
+            putString(out, category);
+        }
+    }
+    putCount(out, encoding.labelCategories.size());
+    for (const auto& category : encoding.labelCategories) {
+        putString(out, category);
+    }
+    return out;
+}
+
+// Bounds-checked reader of an encoding blob
+class BlobReader {
+private:
+    const char* pos;
+    const char* end;
+
+public:
+    BlobReader(const char* data, size_t size) : pos(data), end(data + size) {}
+
+    bool count(uint32_t& value) {
+        if (static_cast<size_t>(end - pos) < sizeof(value)) return false;
+        std::memcpy(&value, pos, sizeof(value));
+        pos += sizeof(value);
+        return true;
+    }
+
+    bool string(std::string& text) {
+        uint32_t length;
+        if (!count(length) || static_cast<size_t>(end - pos) < length) return false;
+        text.assign(pos, length);
+        pos += length;
+        return true;
+    }
+
+    bool strings(std::vector<std::string>& texts) {
+        uint32_t n;
+        if (!count(n)) return false;
+        texts.resize(std::min<size_t>(n, static_cast<size_t>(end - pos)));
+        if (texts.size() != n) return false;
+        for (auto& text : texts) {
+            if (!string(text)) return false;
+        }
+        return true;
+    }
+
+    bool done() const { return pos == end; }
+};
+
+bool decodeBlob(const char* data, size_t size, DatasetCache::Encoding& encoding) {
+    BlobReader reader(data, size);
+    uint32_t columns;
+    if (!reader.count(columns)) return false;
+    encoding.columns.clear();
+    encoding.categories.clear();
+    for (uint32_t c = 0; c < columns; c++) {
+        uint32_t column;
+        std::vector<std::string> categories;
+        if (!reader.count(column) || !reader.strings(categories)) return false;
+        encoding.columns.push_back(static_cast<int>(column));
+        encoding.categories.push_back(std::move(categories));
+    }
+    return reader.strings(encoding.labelCategories) && reader.done();
+}
+
+} // namespace
+
+uint64_t DatasetCache::checksum(const std::string& path) {
+    MappedFile file(path);
+    const char* data = file.data();
+    size_t size = file.size();
+
+    // Whole words first: one multiply per 8 bytes keeps this far below
+    // the cost of parsing the same bytes
+    uint64_t hash = FNV_OFFSET;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * FNV_PRIME;
+    }
+    for (; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+    }
+    return (hash ^ static_cast<uint64_t>(size)) * FNV_PRIME;
+}
+
+DatasetCache::Source DatasetCache::source(const std::string& path, bool withChecksum) {
+    std::error_code error;
+    uintmax_t size = std::filesystem::file_size(path, error);
+    auto modified = std::filesystem::last_write_time(path, error);
+    if (error) {
+        throw std::runtime_error("Cannot open file: " + path);
+    }
+    return {static_cast<uint64_t>(size),
+            static_cast<int64_t>(modified.time_since_epoch().count()),
+            withChecksum ? checksum(path) : 0};
+}
+
+bool DatasetCache::load(const std::string& cachePath, const std::string& key,
+                        const Source& source, Dataset& data, Encoding* encoding) {
+    std::unique_ptr<MappedFile> file;
+    try {
+        file = std::make_unique<MappedFile>(cachePath);
+    } catch (const std::runtime_error&) {
+        return false;
+    }
+
+    CacheHeader header;
+    if (file->size() < sizeof(header)) return false;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (BinaryFile::checkPreamble(header.preamble, CACHE_MAGIC, CACHE_VERSION) !=
+            BinaryFile::PreambleCheck::OK ||
+        header.sourceSize != source.size || header.sourceModified != source.modified ||
+        (source.checksum != 0 && header.sourceChecksum != source.checksum) ||
+        header.fileSize != file->size() ||
+        header.dims == 0) {
+        return false;
+    }
+
+    // Every section must lie inside the file
+    auto inside = [&](uint64_t offset, uint64_t bytes) {
+        return offset >= sizeof(header) && offset <= file->size() &&
+               bytes <= file->size() - offset;
+    };
+    uint64_t maxRows = file->size() / sizeof(double);
+    if (header.rows > maxRows || header.dims > maxRows / std::max<uint64_t>(header.rows, 1) ||
+        !inside(header.keyOffset, header.keyBytes) ||
+        !inside(header.encodingOffset, header.encodingBytes) ||
+        !inside(header.labelsOffset, header.rows * sizeof(int)) ||
+        !inside(header.columnsOffset, header.rows * header.dims * sizeof(double)) ||
+        header.labelsOffset % BinaryFile::SECTION_ALIGNMENT != 0 ||
+        header.columnsOffset % BinaryFile::SECTION_ALIGNMENT != 0) {
+        return false;
+    }
+    if (header.keyBytes != key.size() ||
+        key.compare(0, key.size(), file->data() + header.keyOffset, header.keyBytes) != 0) {
+        return false;
+    }
+
+    Encoding stored;
+    if (!decodeBlob(file->data() + header.encodingOffset, header.encodingBytes, stored)) {
+        return false;
+    }
+
+    // Columns are transposed into rows a block of rows at a time, so the
+    // rows being written stay in cache while every column is read
+    size_t rows = header.rows;
+    size_t dims = header.dims;
+    const int* labels = reinterpret_cast<const int*>(file->data() + header.labelsOffset);
+    const double* columns = reinterpret_cast<const double*>(file->data() + header.columnsOffset);
+    Dataset loaded(rows, dims);
+    for (size_t begin = 0; begin < rows; begin += TRANSPOSE_BLOCK) {
+        size_t end = std::min(rows, begin + TRANSPOSE_BLOCK);
+        for (size_t d = 0; d < dims; d++) {
+            const double* column = columns + d * rows;
+            for (size_t i = begin; i < end; i++) {
+                loaded.rowData(i)[d] = column[i];
+            }
+        }
+        for (size_t i = begin; i < end; i++) {
+            loaded.setLabel(i, labels[i]);
+        }
+    }
+
+    data = std::move(loaded);
+    if (encoding != nullptr) {
+        *encoding = std::move(stored);
+    }
+    return true;
+}
+
+bool DatasetCache::save(const std::string& cachePath, const std::string& key,
+                        const Source& source, const Dataset& data, const Encoding& encoding) {
+    CacheHeader header = {};
+    header.preamble = BinaryFile::makePreamble(CACHE_MAGIC, CACHE_VERSION);
+    header.sourceSize = source.size;
+    header.sourceModified = source.modified;
+    header.sourceChecksum = source.checksum;
+    header.rows = data.size();
+    header.dims = data.dimensions();
+
+    size_t rows = data.size();
+    size_t dims = data.dimensions();
+    std::vector<double> columns(rows * dims);
+    for (size_t i = 0; i < rows; i++) {
+        const double* row = data.rowData(i);
+        for (size_t d = 0; d < dims; d++) {
+            columns[d * rows + i] = row[d];
+        }
+    }
+    std::string blob = encodeBlob(encoding);
+
+    // Written under a temporary name and renamed, so an interrupted save
+    // never leaves a cache that looks complete
+    std::string tempPath = cachePath + ".tmp";
+    BinaryFile::SectionWriter out(tempPath, sizeof(header));
+    if (!out.isOpen()) {
+        return false;
+    }
+    header.keyOffset = out.write(key.data(), key.size(), 1);
+    header.keyBytes = key.size();
+    header.encodingOffset = out.write(blob.data(), blob.size(), 1);
+    header.encodingBytes = blob.size();
+    header.labelsOffset = out.write(data.labels().data(), rows * sizeof(int));
+    header.columnsOffset = out.write(columns.data(), columns.size() * sizeof(double));
+    header.fileSize = out.size();
+    if (!out.finish(&header, sizeof(header))) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::remove(cachePath.c_str());
+    if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
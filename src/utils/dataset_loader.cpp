@@ -1,94 +1,382 @@
 #include "../../include/utils/dataset_loader.h"
+#include "../../include/utils/mapped_file.h"
+#include "../../include/utils/parallel.h"
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include <random>
 #include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <set>
 #include <cctype>
 
-std::vector<Point> DatasetLoader::loadCSV(const std::string& filepath,
-                                           bool hasHeader,
-                                           int labelColumn) {
-    std::vector<Point> data;
-    std::ifstream file(filepath);
+namespace {
 
-    if (!file.is_open()) {
-        throw std::runtime_error("Could not open file: " + filepath);
+// Smallest share of a file given to one parsing worker
+constexpr size_t MIN_PARSE_CHUNK = 1 << 20;
+
+bool isTrimmed(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Parses the number at the start of [first, last) as std::stod would (a
+// leading '+' and hexadecimal are accepted, trailing text ignored); false if
+// there is none or it is out of range
+bool parseNumber(const char* first, const char* last, double& value) {
+    if (*first == '+' && last - first > 1 && first[1] != '-' && first[1] != '+') {
+        first++;
     }
 
-    std::string line;
-    bool firstLine = true;
+    // Fast path (Clinger) for plain decimals of up to 15 digits: mantissa
+    // and power of ten are exact doubles, so one division rounds correctly
+    static const double POWERS_OF_TEN[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                           1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+    const char* p = first + (*first == '-' ? 1 : 0);
+    uint64_t mantissa = 0;
+    int count = 0;
+    int scale = -1;
+    for (; p < last && count <= 15; p++) {
+        if (*p >= '0' && *p <= '9') {
+            mantissa = mantissa * 10 + (*p - '0');
+            count++;
+            if (scale >= 0) scale++;
+        } else if (*p == '.' && scale < 0) {
+            scale = 0;
+        } else {
+            break;
+        }
+    }
+    if (p == last && count > 0 && count <= 15) {
+        value = static_cast<double>(mantissa) / POWERS_OF_TEN[scale > 0 ? scale : 0];
+        if (*first == '-') value = -value;
+        return true;
+    }
 
-    while (std::getline(file, line)) {
-        // Skip header if present
-        if (firstLine && hasHeader) {
-            firstLine = false;
-            continue;
+    const char* digits = first + (*first == '-' ? 1 : 0);
+    if (last - digits > 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X') &&
+        std::isxdigit(static_cast<unsigned char>(digits[2]))) {
+        auto [end, ec] = std::from_chars(digits + 2, last, value, std::chars_format::hex);
+        if (ec == std::errc()) {
+            if (digits != first) value = -value;
+            return true;
         }
+        if (ec != std::errc::invalid_argument) return false;
+    }
 
-        // Skip empty lines
-        if (line.empty()) {
-            continue;
+    auto [end, ec] = std::from_chars(first, last, value);
+    return ec == std::errc() && end != first;
+}
+
+// Parses one CSV line [begin, end) into coordinates (every numeric cell
+// except the label column) and label; returns false for rows without
+// features or label. Cells are trimmed and parsed in place, without copies.
+bool parseNumericRow(const char* begin, const char* end, int labelColumn,
+                     std::vector<double>& allValues, std::vector<double>& coords, int& label) {
+    allValues.clear();
+    coords.clear();
+    label = -1;
+
+    // Parse all cells
+    const char* cell = begin;
+    while (cell < end) {
+        const char* cellEnd = cell;
+        while (cellEnd < end && *cellEnd != ',') cellEnd++;
+
+        // Trim whitespace
+        const char* first = cell;
+        const char* last = cellEnd;
+        while (first < last && isTrimmed(*first)) first++;
+        while (last > first && isTrimmed(last[-1])) last--;
+
+        // Empty and non-numeric cells are skipped
+        double value;
+        if (first < last && parseNumber(first, last, value)) {
+            allValues.push_back(value);
         }
+        cell = cellEnd + 1;
+    }
 
-        std::stringstream ss(line);
-        std::string cell;
-        std::vector<double> allValues;
-        int label = -1;
+    if (allValues.empty()) {
+        return false;
+    }
 
-        // Parse all cells
-        while (std::getline(ss, cell, ',')) {
-            // Trim whitespace
-            cell.erase(0, cell.find_first_not_of(" \t\r\n"));
-            cell.erase(cell.find_last_not_of(" \t\r\n") + 1);
+    // Determine label column index (-1 means last column)
+    int labelIdx = labelColumn;
+    if (labelIdx == -1) {
+        labelIdx = allValues.size() - 1;
+    }
 
-            if (cell.empty()) {
-                continue;
-            }
+    // Extract label and build coordinates vector
+    for (size_t i = 0; i < allValues.size(); i++) {
+        if (static_cast<int>(i) == labelIdx) {
+            label = static_cast<int>(allValues[i]);
+        } else {
+            coords.push_back(allValues[i]);
+        }
+    }
 
-            try {
-                double value = std::stod(cell);
-                allValues.push_back(value);
-            } catch (...) {
-                // If conversion fails, skip this cell
-                continue;
-            }
+    return !coords.empty() && label != -1;
+}
+
+// Calls fn(coords, label) for every numeric row among the lines of
+// [begin, end); empty lines and rows without features or label are skipped
+template <class Fn>
+void forEachNumericRow(const char* begin, const char* end, int labelColumn, Fn&& fn) {
+    std::vector<double> allValues;
+    std::vector<double> coords;
+    int label = -1;
+
+    const char* line = begin;
+    while (line < end) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if (lineEnd == nullptr) {
+            lineEnd = end;
         }
+        if (lineEnd > line && parseNumericRow(line, lineEnd, labelColumn, allValues, coords, label)) {
+            if (!fn(coords, label)) return;
+        }
+        line = lineEnd + 1;
+    }
+}
 
-        if (!allValues.empty()) {
-            // Determine label column index (-1 means last column)
-            int labelIdx = labelColumn;
-            if (labelIdx == -1) {
-                labelIdx = allValues.size() - 1;
-            }
+// A mapped CSV file cut into chunks of whole data lines: chunk c is
+// [bounds[c], bounds[c + 1]). The header line, if any, is in no chunk.
+struct CSVChunks {
+    std::unique_ptr<MappedFile> file;
+    std::vector<const char*> bounds;
 
-            // Extract label and build coordinates vector
-            std::vector<double> coords;
-            for (size_t i = 0; i < allValues.size(); i++) {
-                if (static_cast<int>(i) == labelIdx) {
-                    label = static_cast<int>(allValues[i]);
-                } else {
-                    coords.push_back(allValues[i]);
-                }
-            }
+    size_t count() const { return bounds.size() - 1; }
+};
+
+CSVChunks splitCSV(const std::string& filepath, bool hasHeader, int numThreads) {
+    CSVChunks chunks;
+    try {
+        chunks.file = std::make_unique<MappedFile>(filepath);
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error("Could not open file: " + filepath);
+    }
+
+    const char* begin = chunks.file->data();
+    const char* end = begin + chunks.file->size();
+
+    // Skip header if present
+    if (hasHeader && begin < end) {
+        const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin));
+        begin = newline ? newline + 1 : end;
+    }
+
+    // A few chunks per worker evens out lines of different lengths
+    size_t bytes = end - begin;
+    size_t workers = Parallel::resolveThreads(numThreads);
+    size_t numChunks = std::max<size_t>(1, std::min(workers * 4, bytes / MIN_PARSE_CHUNK));
+    chunks.bounds.assign(numChunks + 1, end);
+    chunks.bounds[0] = begin;
+    for (size_t c = 1; c < numChunks; c++) {
+        const char* cut = std::max(chunks.bounds[c - 1], begin + bytes / numChunks * c);
+        const char* newline = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+        chunks.bounds[c] = newline ? newline + 1 : end;
+    }
+    return chunks;
+}
+
+} // namespace
+
+std::vector<Point> DatasetLoader::loadCSV(const std::string& filepath,
+                                           bool hasHeader,
+                                           int labelColumn) {
+    // Chunks are parsed concurrently and concatenated in file order
+    CSVChunks chunks = splitCSV(filepath, hasHeader, 0);
+    std::vector<std::vector<Point>> parts(chunks.count());
+    Parallel::forEachChunk(chunks.count(), 0, [&](size_t first, size_t last, int) {
+        for (size_t c = first; c < last; c++) {
+            forEachNumericRow(chunks.bounds[c], chunks.bounds[c + 1], labelColumn,
+                              [&](const std::vector<double>& coords, int label) {
+                // Create point with coordinates (excluding label)
+                parts[c].emplace_back(coords, label);
+                return true;
+            });
+        }
+    }, 1);
 
-            // Create point with coordinates (excluding label)
-            if (!coords.empty() && label != -1) {
-                data.emplace_back(coords, label);
+    std::vector<Point> data = std::move(parts.front());
+    for (size_t c = 1; c < parts.size(); c++) {
+        std::move(parts[c].begin(), parts[c].end(), std::back_inserter(data));
+    }
+
+    if (data.empty()) {
+        throw std::runtime_error("No data loaded from file: " + filepath);
+    }
+
+    return data;
+}
+
+Dataset DatasetLoader::loadCSVDataset(const std::string& filepath,
+                                      bool hasHeader,
+                                      int labelColumn,
+                                      int numThreads) {
+    CSVChunks chunks = splitCSV(filepath, hasHeader, numThreads);
+
+    // The first row fixes the dimensionality; ragged rows are skipped
+    size_t dims = 0;
+    for (size_t c = 0; c < chunks.count() && dims == 0; c++) {
+        forEachNumericRow(chunks.bounds[c], chunks.bounds[c + 1], labelColumn,
+                          [&](const std::vector<double>& coords, int) {
+            dims = coords.size();
+            return false;
+        });
+    }
+    if (dims == 0) {
+        throw std::runtime_error("No data loaded from file: " + filepath);
+    }
+
+    // Every line gets a row slot, so chunks parse straight into the matrix
+    std::vector<size_t> slots(chunks.count() + 1, 0);
+    Parallel::forEachChunk(chunks.count(), numThreads, [&](size_t first, size_t last, int) {
+        for (size_t c = first; c < last; c++) {
+            slots[c + 1] = std::count(chunks.bounds[c], chunks.bounds[c + 1], '\n') + 1;
+        }
+    }, 1);
+    for (size_t c = 0; c < chunks.count(); c++) {
+        slots[c + 1] += slots[c];
+    }
+
+    Dataset data(slots.back(), dims);
+    std::vector<size_t> rows(chunks.count(), 0);
+    Parallel::forEachChunk(chunks.count(), numThreads, [&](size_t first, size_t last, int) {
+        for (size_t c = first; c < last; c++) {
+            size_t row = slots[c];
+            forEachNumericRow(chunks.bounds[c], chunks.bounds[c + 1], labelColumn,
+                              [&](const std::vector<double>& coords, int label) {
+                if (coords.size() == dims) {
+                    std::copy(coords.begin(), coords.end(), data.rowData(row));
+                    data.setLabel(row, label);
+                    row++;
+                }
+                return true;
+            });
+            rows[c] = row - slots[c];
+        }
+    }, 1);
+
+    // Close the gaps left by empty and skipped lines
+    size_t total = rows[0];
+    for (size_t c = 1; c < chunks.count(); c++) {
+        if (total != slots[c]) {
+            std::copy(data.rowData(slots[c]), data.rowData(slots[c] + rows[c]), data.rowData(total));
+            for (size_t r = 0; r < rows[c]; r++) {
+                data.setLabel(total + r, data.label(slots[c] + r));
             }
         }
+        total += rows[c];
+    }
+    data.resize(total);
 
-        firstLine = false;
+    return data;
+}
+
+CSVChunkReader::CSVChunkReader(const std::string& filepath, size_t chunkRows, bool hasHeader,
+                               int labelColumn)
+    : filepath(filepath), chunkRows(chunkRows), hasHeader(hasHeader), labelColumn(labelColumn),
+      dims(0), rowsRead(0) {
+    if (chunkRows == 0) {
+        throw std::invalid_argument("chunkRows must be positive");
     }
+    rewind();
+}
 
+void CSVChunkReader::rewind() {
     file.close();
+    file.clear();
+    file.open(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open file: " + filepath);
+    }
+    rowsRead = 0;
 
-    if (data.empty()) {
-        throw std::runtime_error("No data loaded from file: " + filepath);
+    // Skip header if present
+    if (hasHeader) {
+        std::getline(file, line);
     }
+}
+
+bool CSVChunkReader::next(Dataset& chunk) {
+    if (chunk.dimensions() != dims || dims == 0) {
+        chunk = Dataset(dims);
+    }
+    chunk.resize(0);
+
+    int label = -1;
+    while (chunk.size() < chunkRows && std::getline(file, line)) {
+        if (line.empty() ||
+            !parseNumericRow(line.data(), line.data() + line.size(), labelColumn, allValues,
+                             coords, label)) {
+            continue;
+        }
+
+        // The first row fixes the dimensionality; ragged rows are skipped
+        if (dims == 0) {
+            dims = coords.size();
+            chunk = Dataset(dims);
+            chunk.reserve(chunkRows);
+        }
+        if (coords.size() == dims) {
+            chunk.addRow(coords.data(), label);
+        }
+    }
+
+    rowsRead += chunk.size();
+    return !chunk.empty();
+}
 
+Dataset DatasetLoader::loadCSVCached(const std::string& filepath,
+                                     bool hasHeader,
+                                     int labelColumn,
+                                     bool encode,
+                                     const std::string& cachePath,
+                                     DatasetCache::Encoding* encoding,
+                                     bool verifyChecksum) {
+    std::string cache = cachePath.empty() ? DatasetCache::defaultPath(filepath) : cachePath;
+    std::string key = "DatasetLoader::loadCSV header=" + std::to_string(hasHeader) +
+                      " label=" + std::to_string(labelColumn) +
+                      " encode=" + std::to_string(encode);
+
+    // A hit costs a stat of the CSV (plus a read of it with verifyChecksum)
+    DatasetCache::Source source;
+    try {
+        source = DatasetCache::source(filepath, verifyChecksum);
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error("Could not open file: " + filepath);
+    }
+
+    Dataset data;
+    DatasetCache::Encoding used;
+    if (DatasetCache::load(cache, key, source, data, &used)) {
+        if (encoding != nullptr) {
+            *encoding = std::move(used);
+        }
+        return data;
+    }
+
+    if (encode) {
+        data = Dataset::fromPoints(loadCSVEncoded(filepath, hasHeader, {}, labelColumn, &used));
+    } else {
+        data = loadCSVDataset(filepath, hasHeader, labelColumn);
+    }
+
+    // The checksum is recorded so later loads can verify contents; a cache
+    // that cannot be written only costs the next load a parse
+    if (source.checksum == 0) {
+        source.checksum = DatasetCache::checksum(filepath);
+    }
+    DatasetCache::save(cache, key, source, data, used);
+    if (encoding != nullptr) {
+        *encoding = std::move(used);
+    }
     return data;
 }
 
@@ -305,6 +593,14 @@ std::vector<Point> DatasetLoader::loadCSVWithEncoding(const std::string& filepat
                                                        bool hasHeader,
                                                        const std::vector<int>& categoricalColumns,
                                                        int labelColumn) {
+    return loadCSVEncoded(filepath, hasHeader, categoricalColumns, labelColumn, nullptr);
+}
+
+std::vector<Point> DatasetLoader::loadCSVEncoded(const std::string& filepath,
+                                                  bool hasHeader,
+                                                  const std::vector<int>& categoricalColumns,
+                                                  int labelColumn,
+                                                  DatasetCache::Encoding* encoding) {
     std::ifstream file(filepath);
 
     if (!file.is_open()) {
@@ -401,6 +697,17 @@ std::vector<Point> DatasetLoader::loadCSVWithEncoding(const std::string& filepat
         }
     }
 
+    if (encoding != nullptr) {
+        *encoding = DatasetCache::Encoding();
+        for (const auto& [colIdx, values] : categoryValues) {
+            encoding->columns.push_back(colIdx);
+            encoding->categories.emplace_back(values.begin(), values.end());
+        }
+        if (labelIsCategorical) {
+            encoding->labelCategories.assign(labelValues.begin(), labelValues.end());
+        }
+    }
+
     // Second pass: load data with one-hot encoding
     file.clear();
     file.seekg(0);
@@ -442,13 +749,13 @@ std::vector<Point> DatasetLoader::loadCSVWithEncoding(const std::string& filepat
             // Skip label column - it will be processed separately
             if (static_cast<int>(i) == labelIdx) {
                 // Extract label
-                try {
-                    label = static_cast<int>(std::stod(cells[i]));
-                } catch (...) {
+                const std::string& cell = cells[i];
+                double value;
+                if (!cell.empty() && parseNumber(cell.data(), cell.data() + cell.size(), value)) {
+                    label = static_cast<int>(value);
+                } else if (categoryEncoding.count(i)) {
                     // If label is categorical, encode it
-                    if (categoryEncoding.count(i)) {
-                        label = categoryEncoding[i][cells[i]];
-                    }
+                    label = categoryEncoding[i][cell];
                 }
                 continue;
             }
@@ -464,11 +771,12 @@ std::vector<Point> DatasetLoader::loadCSVWithEncoding(const std::string& filepat
                 }
             } else {
                 // Numeric column
-                try {
-                    coords.push_back(std::stod(cells[i]));
-                } catch (...) {
-                    coords.push_back(0.0);
+                const std::string& cell = cells[i];
+                double value;
+                if (cell.empty() || !parseNumber(cell.data(), cell.data() + cell.size(), value)) {
+                    value = 0.0;
                 }
+                coords.push_back(value);
             }
         }
 
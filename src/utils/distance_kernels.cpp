@@ -0,0 +1,1033 @@
+#include "../../include/utils/distance_kernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define KNN_X86_SIMD 1
+#include <immintrin.h>
+#define KNN_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+namespace DistanceKernels {
+
+namespace {
+
+// Scalar versions, also used for the tails of the vector loops
+
+template <typename T>
+T squaredEuclideanScalar(const T* a, const T* b, size_t n, T sum = 0) {
+    for (size_t i = 0; i < n; i++) {
+        T diff = a[i] - b[i];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+template <typename T>
+T manhattanScalar(const T* a, const T* b, size_t n, T sum = 0) {
+    for (size_t i = 0; i < n; i++) {
+        sum += std::abs(a[i] - b[i]);
+    }
+    return sum;
+}
+
+template <typename T>
+T chebyshevScalar(const T* a, const T* b, size_t n, T maxDiff = 0) {
+    for (size_t i = 0; i < n; i++) {
+        maxDiff = std::max(maxDiff, std::abs(a[i] - b[i]));
+    }
+    return maxDiff;
+}
+
+template <typename T>
+void accumulateSquaredScalar(const T* x, T q, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        T diff = x[i] - q;
+        out[i] += diff * diff;
+    }
+}
+
+template <typename T>
+void accumulateAbsScalar(const T* x, T q, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] += std::abs(x[i] - q);
+    }
+}
+
+template <typename T>
+void accumulateMaxAbsScalar(const T* x, T q, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = std::max(out[i], std::abs(x[i] - q));
+    }
+}
+
+template <typename T>
+void accumulateScaledScalar(const T* x, T s, T* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] += s * x[i];
+    }
+}
+
+// Dot products of DOT_QUERIES queries with columns [begin, n) of an
+// axis-major block; full groups of 8 columns have a fixed-width body the
+// compiler keeps in registers
+template <size_t Width>
+void dotProductsColumns(const double* const* queries, const double* x, size_t stride, size_t dims,
+                        double* out, size_t n, size_t j, size_t width) {
+    double acc[DOT_QUERIES][Width] = {};
+    for (size_t d = 0; d < dims; d++) {
+        const double* xd = x + d * stride + j;
+        for (size_t i = 0; i < DOT_QUERIES; i++) {
+            double s = queries[i][d];
+            for (size_t r = 0; r < (Width == 8 ? 8 : width); r++) {
+                acc[i][r] += s * xd[r];
+            }
+        }
+    }
+    for (size_t i = 0; i < DOT_QUERIES; i++) {
+        std::copy(acc[i], acc[i] + width, out + i * n + j);
+    }
+}
+
+void dotProductsScalar(const double* const* queries, const double* x, size_t stride, size_t dims,
+                       double* out, size_t n, size_t begin = 0) {
+    size_t j = begin;
+    for (; j + 8 <= n; j += 8) {
+        dotProductsColumns<8>(queries, x, stride, dims, out, n, j, 8);
+    }
+    if (j < n) {
+        dotProductsColumns<7>(queries, x, stride, dims, out, n, j, n - j);
+    }
+}
+
+#ifdef KNN_X86_SIMD
+
+// ---- SSE2: 2 doubles / 4 floats per register ----
+
+KNN_TARGET("sse2") double hsum(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+KNN_TARGET("sse2") double hmax(__m128d v) {
+    return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+KNN_TARGET("sse2") float hsum(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(v, _mm_shuffle_ps(v, v, 1)));
+}
+
+KNN_TARGET("sse2") float hmax(__m128 v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_max_ss(v, _mm_shuffle_ps(v, v, 1)));
+}
+
+KNN_TARGET("sse2") double squaredEuclideanSse2(const double* a, const double* b, size_t n) {
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+        acc = _mm_add_pd(acc, _mm_mul_pd(d, d));
+    }
+    return squaredEuclideanScalar(a + i, b + i, n - i, hsum(acc));
+}
+
+KNN_TARGET("sse2") double manhattanSse2(const double* a, const double* b, size_t n) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+        acc = _mm_add_pd(acc, _mm_andnot_pd(sign, d));
+    }
+    return manhattanScalar(a + i, b + i, n - i, hsum(acc));
+}
+
+KNN_TARGET("sse2") double chebyshevSse2(const double* a, const double* b, size_t n) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    __m128d acc = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_sub_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i));
+        acc = _mm_max_pd(acc, _mm_andnot_pd(sign, d));
+    }
+    return chebyshevScalar(a + i, b + i, n - i, hmax(acc));
+}
+
+KNN_TARGET("sse2") float squaredEuclideanSse2(const float* a, const float* b, size_t n) {
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        acc = _mm_add_ps(acc, _mm_mul_ps(d, d));
+    }
+    return squaredEuclideanScalar(a + i, b + i, n - i, hsum(acc));
+}
+
+KNN_TARGET("sse2") float manhattanSse2(const float* a, const float* b, size_t n) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        acc = _mm_add_ps(acc, _mm_andnot_ps(sign, d));
+    }
+    return manhattanScalar(a + i, b + i, n - i, hsum(acc));
+}
+
+KNN_TARGET("sse2") float chebyshevSse2(const float* a, const float* b, size_t n) {
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 acc = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        acc = _mm_max_ps(acc, _mm_andnot_ps(sign, d));
+    }
+    return chebyshevScalar(a + i, b + i, n - i, hmax(acc));
+}
+
+KNN_TARGET("sse2") void accumulateSquaredSse2(const double* x, double q, double* out, size_t n) {
+    const __m128d qv = _mm_set1_pd(q);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_sub_pd(_mm_loadu_pd(x + i), qv);
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), _mm_mul_pd(d, d)));
+    }
+    accumulateSquaredScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("sse2") void accumulateAbsSse2(const double* x, double q, double* out, size_t n) {
+    const __m128d qv = _mm_set1_pd(q);
+    const __m128d sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(x + i), qv));
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), d));
+    }
+    accumulateAbsScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("sse2") void accumulateMaxAbsSse2(const double* x, double q, double* out, size_t n) {
+    const __m128d qv = _mm_set1_pd(q);
+    const __m128d sign = _mm_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_andnot_pd(sign, _mm_sub_pd(_mm_loadu_pd(x + i), qv));
+        _mm_storeu_pd(out + i, _mm_max_pd(_mm_loadu_pd(out + i), d));
+    }
+    accumulateMaxAbsScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("sse2") void accumulateSquaredSse2(const float* x, float q, float* out, size_t n) {
+    const __m128 qv = _mm_set1_ps(q);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(x + i), qv);
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(d, d)));
+    }
+    accumulateSquaredScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("sse2") void accumulateAbsSse2(const float* x, float q, float* out, size_t n) {
+    const __m128 qv = _mm_set1_ps(q);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(x + i), qv));
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), d));
+    }
+    accumulateAbsScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("sse2") void accumulateMaxAbsSse2(const float* x, float q, float* out, size_t n) {
+    const __m128 qv = _mm_set1_ps(q);
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 d = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(x + i), qv));
+        _mm_storeu_ps(out + i, _mm_max_ps(_mm_loadu_ps(out + i), d));
+    }
+    accumulateMaxAbsScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("sse2") void accumulateScaledSse2(const double* x, double s, double* out, size_t n) {
+    const __m128d sv = _mm_set1_pd(s);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_add_pd(_mm_loadu_pd(out + i), _mm_mul_pd(sv, _mm_loadu_pd(x + i))));
+    }
+    accumulateScaledScalar(x + i, s, out + i, n - i);
+}
+
+KNN_TARGET("sse2") void accumulateScaledSse2(const float* x, float s, float* out, size_t n) {
+    const __m128 sv = _mm_set1_ps(s);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(sv, _mm_loadu_ps(x + i))));
+    }
+    accumulateScaledScalar(x + i, s, out + i, n - i);
+}
+
+// 4 queries x 4 columns: eight accumulators, each loaded pair of columns
+// is reused by every query
+KNN_TARGET("sse2") void dotProductsSse2(const double* const* queries, const double* x,
+                                        size_t stride, size_t dims, double* out, size_t n) {
+    size_t j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128d acc[DOT_QUERIES][2];
+        for (size_t i = 0; i < DOT_QUERIES; i++) {
+            acc[i][0] = acc[i][1] = _mm_setzero_pd();
+        }
+        for (size_t d = 0; d < dims; d++) {
+            const double* xd = x + d * stride + j;
+            __m128d x0 = _mm_loadu_pd(xd);
+            __m128d x1 = _mm_loadu_pd(xd + 2);
+            for (size_t i = 0; i < DOT_QUERIES; i++) {
+                __m128d s = _mm_set1_pd(queries[i][d]);
+                acc[i][0] = _mm_add_pd(acc[i][0], _mm_mul_pd(s, x0));
+                acc[i][1] = _mm_add_pd(acc[i][1], _mm_mul_pd(s, x1));
+            }
+        }
+        for (size_t i = 0; i < DOT_QUERIES; i++) {
+            _mm_storeu_pd(out + i * n + j, acc[i][0]);
+            _mm_storeu_pd(out + i * n + j + 2, acc[i][1]);
+        }
+    }
+    dotProductsScalar(queries, x, stride, dims, out, n, j);
+}
+
+// ---- AVX2 + FMA: 4 doubles / 8 floats per register ----
+
+KNN_TARGET("avx2,fma") double hsum(__m256d v) {
+    return hsum(_mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+KNN_TARGET("avx2,fma") double hmax(__m256d v) {
+    return hmax(_mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+}
+
+KNN_TARGET("avx2,fma") float hsum(__m256 v) {
+    return hsum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+KNN_TARGET("avx2,fma") float hmax(__m256 v) {
+    return hmax(_mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+}
+
+KNN_TARGET("avx2,fma") double squaredEuclideanAvx2(const double* a, const double* b, size_t n) {
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        acc = _mm256_fmadd_pd(d, d, acc);
+    }
+    return squaredEuclideanScalar(a + i, b + i, n - i, hsum(acc));
+}
+
+KNN_TARGET("avx2,fma") double manhattanAvx2(const double* a, const double* b, size_t n) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        acc = _mm256_add_pd(acc, _mm256_andnot_pd(sign, d));
+    }
+    return manhattanScalar(a + i, b + i, n - i, hsum(acc));
+}
+
+KNN_TARGET("avx2,fma") double chebyshevAvx2(const double* a, const double* b, size_t n) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d acc = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i));
+        acc = _mm256_max_pd(acc, _mm256_andnot_pd(sign, d));
+    }
+    return chebyshevScalar(a + i, b + i, n - i, hmax(acc));
+}
+
+KNN_TARGET("avx2,fma") float squaredEuclideanAvx2(const float* a, const float* b, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        acc = _mm256_fmadd_ps(d, d, acc);
+    }
+    return squaredEuclideanScalar(a + i, b + i, n - i, hsum(acc));
+}
+
+KNN_TARGET("avx2,fma") float manhattanAvx2(const float* a, const float* b, size_t n) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        acc = _mm256_add_ps(acc, _mm256_andnot_ps(sign, d));
+    }
+    return manhattanScalar(a + i, b + i, n - i, hsum(acc));
+}
+
+KNN_TARGET("avx2,fma") float chebyshevAvx2(const float* a, const float* b, size_t n) {
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i));
+        acc = _mm256_max_ps(acc, _mm256_andnot_ps(sign, d));
+    }
+    return chebyshevScalar(a + i, b + i, n - i, hmax(acc));
+}
+
+KNN_TARGET("avx2,fma") void accumulateSquaredAvx2(const double* x, double q, double* out, size_t n) {
+    const __m256d qv = _mm256_set1_pd(q);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_sub_pd(_mm256_loadu_pd(x + i), qv);
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(d, d, _mm256_loadu_pd(out + i)));
+    }
+    accumulateSquaredScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("avx2,fma") void accumulateAbsAvx2(const double* x, double q, double* out, size_t n) {
+    const __m256d qv = _mm256_set1_pd(q);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(x + i), qv));
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i), d));
+    }
+    accumulateAbsScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("avx2,fma") void accumulateMaxAbsAvx2(const double* x, double q, double* out, size_t n) {
+    const __m256d qv = _mm256_set1_pd(q);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_andnot_pd(sign, _mm256_sub_pd(_mm256_loadu_pd(x + i), qv));
+        _mm256_storeu_pd(out + i, _mm256_max_pd(_mm256_loadu_pd(out + i), d));
+    }
+    accumulateMaxAbsScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("avx2,fma") void accumulateSquaredAvx2(const float* x, float q, float* out, size_t n) {
+    const __m256 qv = _mm256_set1_ps(q);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_sub_ps(_mm256_loadu_ps(x + i), qv);
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(d, d, _mm256_loadu_ps(out + i)));
+    }
+    accumulateSquaredScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("avx2,fma") void accumulateAbsAvx2(const float* x, float q, float* out, size_t n) {
+    const __m256 qv = _mm256_set1_ps(q);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(x + i), qv));
+        _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), d));
+    }
+    accumulateAbsScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("avx2,fma") void accumulateMaxAbsAvx2(const float* x, float q, float* out, size_t n) {
+    const __m256 qv = _mm256_set1_ps(q);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 d = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(x + i), qv));
+        _mm256_storeu_ps(out + i, _mm256_max_ps(_mm256_loadu_ps(out + i), d));
+    }
+    accumulateMaxAbsScalar(x + i, q, out + i, n - i);
+}
+
+KNN_TARGET("avx2,fma") void accumulateScaledAvx2(const double* x, double s, double* out, size_t n) {
+    const __m256d sv = _mm256_set1_pd(s);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_fmadd_pd(sv, _mm256_loadu_pd(x + i), _mm256_loadu_pd(out + i)));
+    }
+    accumulateScaledScalar(x + i, s, out + i, n - i);
+}
+
+KNN_TARGET("avx2,fma") void accumulateScaledAvx2(const float* x, float s, float* out, size_t n) {
+    const __m256 sv = _mm256_set1_ps(s);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(sv, _mm256_loadu_ps(x + i), _mm256_loadu_ps(out + i)));
+    }
+    accumulateScaledScalar(x + i, s, out + i, n - i);
+}
+
+// ---- AVX-512F: 8 doubles / 16 floats per register, masked tails ----
+
+// Horizontal reductions fold the upper 256-bit half onto the lower one and
+// finish in AVX registers. The _mm512_reduce_* helpers and the unmasked
+// extracts (casts included) trip GCC's uninitialized-value warnings, hence
+// the masked extracts.
+KNN_TARGET("avx512f") __m256d lowHalf(__m512d v) {
+    return _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, v, 0);
+}
+KNN_TARGET("avx512f") __m256d highHalf(__m512d v) {
+    return _mm512_mask_extractf64x4_pd(_mm256_setzero_pd(), 0xF, v, 1);
+}
+KNN_TARGET("avx512f") __m256 lowHalf(__m512 v) {
+    return _mm256_castpd_ps(lowHalf(_mm512_castps_pd(v)));
+}
+KNN_TARGET("avx512f") __m256 highHalf(__m512 v) {
+    return _mm256_castpd_ps(highHalf(_mm512_castps_pd(v)));
+}
+
+KNN_TARGET("avx512f") double hsum(__m512d v) {
+    return hsum(_mm256_add_pd(lowHalf(v), highHalf(v)));
+}
+
+KNN_TARGET("avx512f") double hmax(__m512d v) {
+    return hmax(_mm256_max_pd(lowHalf(v), highHalf(v)));
+}
+
+KNN_TARGET("avx512f") float hsum(__m512 v) {
+    return hsum(_mm256_add_ps(lowHalf(v), highHalf(v)));
+}
+
+KNN_TARGET("avx512f") float hmax(__m512 v) {
+    return hmax(_mm256_max_ps(lowHalf(v), highHalf(v)));
+}
+
+// Merge-masked max: the unmasked intrinsic trips the same warnings
+KNN_TARGET("avx512f") __m512d max512(__m512d a, __m512d b) {
+    return _mm512_mask_max_pd(a, 0xFF, a, b);
+}
+
+KNN_TARGET("avx512f") __m512 max512(__m512 a, __m512 b) {
+    return _mm512_mask_max_ps(a, 0xFFFF, a, b);
+}
+
+KNN_TARGET("avx512f") __mmask8 tailMask8(size_t remaining) {
+    return static_cast<__mmask8>((1u << remaining) - 1);
+}
+
+KNN_TARGET("avx512f") __mmask16 tailMask16(size_t remaining) {
+    return static_cast<__mmask16>((1u << remaining) - 1);
+}
+
+KNN_TARGET("avx512f") double squaredEuclideanAvx512(const double* a, const double* b, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d d = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+        acc = _mm512_fmadd_pd(d, d, acc);
+    }
+    if (i < n) {
+        __mmask8 m = tailMask8(n - i);
+        __m512d d = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i));
+        acc = _mm512_fmadd_pd(d, d, acc);
+    }
+    return hsum(acc);
+}
+
+KNN_TARGET("avx512f") double manhattanAvx512(const double* a, const double* b, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d d = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+        acc = _mm512_add_pd(acc, _mm512_abs_pd(d));
+    }
+    if (i < n) {
+        __mmask8 m = tailMask8(n - i);
+        __m512d d = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i));
+        acc = _mm512_add_pd(acc, _mm512_abs_pd(d));
+    }
+    return hsum(acc);
+}
+
+KNN_TARGET("avx512f") double chebyshevAvx512(const double* a, const double* b, size_t n) {
+    __m512d acc = _mm512_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d d = _mm512_sub_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i));
+        acc = max512(acc, _mm512_abs_pd(d));
+    }
+    if (i < n) {
+        __mmask8 m = tailMask8(n - i);
+        __m512d d = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, a + i), _mm512_maskz_loadu_pd(m, b + i));
+        acc = max512(acc, _mm512_abs_pd(d));
+    }
+    return hmax(acc);
+}
+
+KNN_TARGET("avx512f") float squaredEuclideanAvx512(const float* a, const float* b, size_t n) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        acc = _mm512_fmadd_ps(d, d, acc);
+    }
+    if (i < n) {
+        __mmask16 m = tailMask16(n - i);
+        __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i));
+        acc = _mm512_fmadd_ps(d, d, acc);
+    }
+    return hsum(acc);
+}
+
+KNN_TARGET("avx512f") float manhattanAvx512(const float* a, const float* b, size_t n) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        acc = _mm512_add_ps(acc, _mm512_abs_ps(d));
+    }
+    if (i < n) {
+        __mmask16 m = tailMask16(n - i);
+        __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i));
+        acc = _mm512_add_ps(acc, _mm512_abs_ps(d));
+    }
+    return hsum(acc);
+}
+
+KNN_TARGET("avx512f") float chebyshevAvx512(const float* a, const float* b, size_t n) {
+    __m512 acc = _mm512_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i));
+        acc = max512(acc, _mm512_abs_ps(d));
+    }
+    if (i < n) {
+        __mmask16 m = tailMask16(n - i);
+        __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, a + i), _mm512_maskz_loadu_ps(m, b + i));
+        acc = max512(acc, _mm512_abs_ps(d));
+    }
+    return hmax(acc);
+}
+
+KNN_TARGET("avx512f") void accumulateSquaredAvx512(const double* x, double q, double* out, size_t n) {
+    const __m512d qv = _mm512_set1_pd(q);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d d = _mm512_sub_pd(_mm512_loadu_pd(x + i), qv);
+        _mm512_storeu_pd(out + i, _mm512_fmadd_pd(d, d, _mm512_loadu_pd(out + i)));
+    }
+    if (i < n) {
+        __mmask8 m = tailMask8(n - i);
+        __m512d d = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, x + i), qv);
+        _mm512_mask_storeu_pd(out + i, m, _mm512_fmadd_pd(d, d, _mm512_maskz_loadu_pd(m, out + i)));
+    }
+}
+
+KNN_TARGET("avx512f") void accumulateAbsAvx512(const double* x, double q, double* out, size_t n) {
+    const __m512d qv = _mm512_set1_pd(q);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d d = _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(x + i), qv));
+        _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_loadu_pd(out + i), d));
+    }
+    if (i < n) {
+        __mmask8 m = tailMask8(n - i);
+        __m512d d = _mm512_abs_pd(_mm512_sub_pd(_mm512_maskz_loadu_pd(m, x + i), qv));
+        _mm512_mask_storeu_pd(out + i, m, _mm512_add_pd(_mm512_maskz_loadu_pd(m, out + i), d));
+    }
+}
+
+KNN_TARGET("avx512f") void accumulateMaxAbsAvx512(const double* x, double q, double* out, size_t n) {
+    const __m512d qv = _mm512_set1_pd(q);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512d d = _mm512_abs_pd(_mm512_sub_pd(_mm512_loadu_pd(x + i), qv));
+        _mm512_storeu_pd(out + i, max512(_mm512_loadu_pd(out + i), d));
+    }
+    if (i < n) {
+        __mmask8 m = tailMask8(n - i);
+        __m512d d = _mm512_abs_pd(_mm512_sub_pd(_mm512_maskz_loadu_pd(m, x + i), qv));
+        _mm512_mask_storeu_pd(out + i, m, max512(_mm512_maskz_loadu_pd(m, out + i), d));
+    }
+}
+
+KNN_TARGET("avx512f") void accumulateSquaredAvx512(const float* x, float q, float* out, size_t n) {
+    const __m512 qv = _mm512_set1_ps(q);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 d = _mm512_sub_ps(_mm512_loadu_ps(x + i), qv);
+        _mm512_storeu_ps(out + i, _mm512_fmadd_ps(d, d, _mm512_loadu_ps(out + i)));
+    }
+    if (i < n) {
+        __mmask16 m = tailMask16(n - i);
+        __m512 d = _mm512_sub_ps(_mm512_maskz_loadu_ps(m, x + i), qv);
+        _mm512_mask_storeu_ps(out + i, m, _mm512_fmadd_ps(d, d, _mm512_maskz_loadu_ps(m, out + i)));
+    }
+}
+
+KNN_TARGET("avx512f") void accumulateAbsAvx512(const float* x, float q, float* out, size_t n) {
+    const __m512 qv = _mm512_set1_ps(q);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 d = _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(x + i), qv));
+        _mm512_storeu_ps(out + i, _mm512_add_ps(_mm512_loadu_ps(out + i), d));
+    }
+    if (i < n) {
+        __mmask16 m = tailMask16(n - i);
+        __m512 d = _mm512_abs_ps(_mm512_sub_ps(_mm512_maskz_loadu_ps(m, x + i), qv));
+        _mm512_mask_storeu_ps(out + i, m, _mm512_add_ps(_mm512_maskz_loadu_ps(m, out + i), d));
+    }
+}
+
+KNN_TARGET("avx512f") void accumulateMaxAbsAvx512(const float* x, float q, float* out, size_t n) {
+    const __m512 qv = _mm512_set1_ps(q);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 d = _mm512_abs_ps(_mm512_sub_ps(_mm512_loadu_ps(x + i), qv));
+        _mm512_storeu_ps(out + i, max512(_mm512_loadu_ps(out + i), d));
+    }
+    if (i < n) {
+        __mmask16 m = tailMask16(n - i);
+        __m512 d = _mm512_abs_ps(_mm512_sub_ps(_mm512_maskz_loadu_ps(m, x + i), qv));
+        _mm512_mask_storeu_ps(out + i, m, max512(_mm512_maskz_loadu_ps(m, out + i), d));
+    }
+}
+
+KNN_TARGET("avx512f") void accumulateScaledAvx512(const double* x, double s, double* out, size_t n) {
+    const __m512d sv = _mm512_set1_pd(s);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(out + i, _mm512_fmadd_pd(sv, _mm512_loadu_pd(x + i), _mm512_loadu_pd(out + i)));
+    }
+    if (i < n) {
+        __mmask8 m = tailMask8(n - i);
+        _mm512_mask_storeu_pd(out + i, m, _mm512_fmadd_pd(sv, _mm512_maskz_loadu_pd(m, x + i),
+                                                          _mm512_maskz_loadu_pd(m, out + i)));
+    }
+}
+
+KNN_TARGET("avx512f") void accumulateScaledAvx512(const float* x, float s, float* out, size_t n) {
+    const __m512 sv = _mm512_set1_ps(s);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        _mm512_storeu_ps(out + i, _mm512_fmadd_ps(sv, _mm512_loadu_ps(x + i), _mm512_loadu_ps(out + i)));
+    }
+    if (i < n) {
+        __mmask16 m = tailMask16(n - i);
+        _mm512_mask_storeu_ps(out + i, m, _mm512_fmadd_ps(sv, _mm512_maskz_loadu_ps(m, x + i),
+                                                          _mm512_maskz_loadu_ps(m, out + i)));
+    }
+}
+
+// 4 queries x 8 columns (AVX2) or x 16 columns (AVX-512) held in eight
+// registers across all axes
+KNN_TARGET("avx2,fma") void dotProductsAvx2(const double* const* queries, const double* x,
+                                            size_t stride, size_t dims, double* out, size_t n) {
+    size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256d acc[DOT_QUERIES][2];
+        for (size_t i = 0; i < DOT_QUERIES; i++) {
+            acc[i][0] = acc[i][1] = _mm256_setzero_pd();
+        }
+        for (size_t d = 0; d < dims; d++) {
+            const double* xd = x + d * stride + j;
+            __m256d x0 = _mm256_loadu_pd(xd);
+            __m256d x1 = _mm256_loadu_pd(xd + 4);
+            for (size_t i = 0; i < DOT_QUERIES; i++) {
+                __m256d s = _mm256_set1_pd(queries[i][d]);
+                acc[i][0] = _mm256_fmadd_pd(s, x0, acc[i][0]);
+                acc[i][1] = _mm256_fmadd_pd(s, x1, acc[i][1]);
+            }
+        }
+        for (size_t i = 0; i < DOT_QUERIES; i++) {
+            _mm256_storeu_pd(out + i * n + j, acc[i][0]);
+            _mm256_storeu_pd(out + i * n + j + 4, acc[i][1]);
+        }
+    }
+    dotProductsScalar(queries, x, stride, dims, out, n, j);
+}
+
+KNN_TARGET("avx512f") void dotProductsAvx512(const double* const* queries, const double* x,
+                                             size_t stride, size_t dims, double* out, size_t n) {
+    size_t j = 0;
+    for (; j + 16 <= n; j += 16) {
+        __m512d acc[DOT_QUERIES][2];
+        for (size_t i = 0; i < DOT_QUERIES; i++) {
+            acc[i][0] = acc[i][1] = _mm512_setzero_pd();
+        }
+        for (size_t d = 0; d < dims; d++) {
+            const double* xd = x + d * stride + j;
+            __m512d x0 = _mm512_loadu_pd(xd);
+            __m512d x1 = _mm512_loadu_pd(xd + 8);
+            for (size_t i = 0; i < DOT_QUERIES; i++) {
+                __m512d s = _mm512_set1_pd(queries[i][d]);
+                acc[i][0] = _mm512_fmadd_pd(s, x0, acc[i][0]);
+                acc[i][1] = _mm512_fmadd_pd(s, x1, acc[i][1]);
+            }
+        }
+        for (size_t i = 0; i < DOT_QUERIES; i++) {
+            _mm512_storeu_pd(out + i * n + j, acc[i][0]);
+            _mm512_storeu_pd(out + i * n + j + 8, acc[i][1]);
+        }
+    }
+    dotProductsScalar(queries, x, stride, dims, out, n, j);
+}
+
+// One-to-many: the row kernel is a template argument, so it is inlined into
+// a loop compiled for the same instruction set and dispatch happens once
+// per block instead of once per row
+
+template <typename T, T (*Kernel)(const T*, const T*, size_t)>
+KNN_TARGET("sse2") void manySse2(const T* query, const T* rows, size_t count, size_t dims, T* out) {
+    for (size_t r = 0; r < count; r++) {
+        out[r] = Kernel(query, rows + r * dims, dims);
+    }
+}
+
+template <typename T, T (*Kernel)(const T*, const T*, size_t)>
+KNN_TARGET("avx2,fma") void manyAvx2(const T* query, const T* rows, size_t count, size_t dims, T* out) {
+    for (size_t r = 0; r < count; r++) {
+        out[r] = Kernel(query, rows + r * dims, dims);
+    }
+}
+
+template <typename T, T (*Kernel)(const T*, const T*, size_t)>
+KNN_TARGET("avx512f") void manyAvx512(const T* query, const T* rows, size_t count, size_t dims, T* out) {
+    for (size_t r = 0; r < count; r++) {
+        out[r] = Kernel(query, rows + r * dims, dims);
+    }
+}
+
+#endif // KNN_X86_SIMD
+
+template <typename T, T (*Kernel)(const T*, const T*, size_t, T)>
+void manyScalar(const T* query, const T* rows, size_t count, size_t dims, T* out) {
+    for (size_t r = 0; r < count; r++) {
+        out[r] = Kernel(query, rows + r * dims, dims, 0);
+    }
+}
+
+// Kernel table of one instruction set
+struct Table {
+    Isa isa;
+    double (*squaredEuclideanD)(const double*, const double*, size_t);
+    double (*manhattanD)(const double*, const double*, size_t);
+    double (*chebyshevD)(const double*, const double*, size_t);
+    float (*squaredEuclideanF)(const float*, const float*, size_t);
+    float (*manhattanF)(const float*, const float*, size_t);
+    float (*chebyshevF)(const float*, const float*, size_t);
+    void (*accumulateSquaredD)(const double*, double, double*, size_t);
+    void (*accumulateAbsD)(const double*, double, double*, size_t);
+    void (*accumulateMaxAbsD)(const double*, double, double*, size_t);
+    void (*accumulateSquaredF)(const float*, float, float*, size_t);
+    void (*accumulateAbsF)(const float*, float, float*, size_t);
+    void (*accumulateMaxAbsF)(const float*, float, float*, size_t);
+    void (*squaredEuclideanManyD)(const double*, const double*, size_t, size_t, double*);
+    void (*manhattanManyD)(const double*, const double*, size_t, size_t, double*);
+    void (*chebyshevManyD)(const double*, const double*, size_t, size_t, double*);
+    void (*squaredEuclideanManyF)(const float*, const float*, size_t, size_t, float*);
+    void (*manhattanManyF)(const float*, const float*, size_t, size_t, float*);
+    void (*chebyshevManyF)(const float*, const float*, size_t, size_t, float*);
+    void (*accumulateScaledD)(const double*, double, double*, size_t);
+    void (*accumulateScaledF)(const float*, float, float*, size_t);
+    void (*dotProductsD)(const double* const*, const double*, size_t, size_t, double*, size_t);
+};
+
+// Scalar entry points with the plain (pointer, pointer, length) signature
+double squaredEuclideanScalarD(const double* a, const double* b, size_t n) { return squaredEuclideanScalar(a, b, n); }
+double manhattanScalarD(const double* a, const double* b, size_t n) { return manhattanScalar(a, b, n); }
+double chebyshevScalarD(const double* a, const double* b, size_t n) { return chebyshevScalar(a, b, n); }
+float squaredEuclideanScalarF(const float* a, const float* b, size_t n) { return squaredEuclideanScalar(a, b, n); }
+float manhattanScalarF(const float* a, const float* b, size_t n) { return manhattanScalar(a, b, n); }
+float chebyshevScalarF(const float* a, const float* b, size_t n) { return chebyshevScalar(a, b, n); }
+void dotProductsScalarD(const double* const* queries, const double* x, size_t stride, size_t dims,
+                        double* out, size_t n) { dotProductsScalar(queries, x, stride, dims, out, n); }
+
+Table makeTable(Isa isa) {
+    switch (isa) {
+#ifdef KNN_X86_SIMD
+        case Isa::AVX512:
+            return {isa,
+                    squaredEuclideanAvx512, manhattanAvx512, chebyshevAvx512,
+                    squaredEuclideanAvx512, manhattanAvx512, chebyshevAvx512,
+                    accumulateSquaredAvx512, accumulateAbsAvx512, accumulateMaxAbsAvx512,
+                    accumulateSquaredAvx512, accumulateAbsAvx512, accumulateMaxAbsAvx512,
+                    manyAvx512<double, squaredEuclideanAvx512>, manyAvx512<double, manhattanAvx512>,
+                    manyAvx512<double, chebyshevAvx512>,
+                    manyAvx512<float, squaredEuclideanAvx512>, manyAvx512<float, manhattanAvx512>,
+                    manyAvx512<float, chebyshevAvx512>,
+                    accumulateScaledAvx512, accumulateScaledAvx512,
+                    dotProductsAvx512};
+        case Isa::AVX2:
+            return {isa,
+                    squaredEuclideanAvx2, manhattanAvx2, chebyshevAvx2,
+                    squaredEuclideanAvx2, manhattanAvx2, chebyshevAvx2,
+                    accumulateSquaredAvx2, accumulateAbsAvx2, accumulateMaxAbsAvx2,
+                    accumulateSquaredAvx2, accumulateAbsAvx2, accumulateMaxAbsAvx2,
+                    manyAvx2<double, squaredEuclideanAvx2>, manyAvx2<double, manhattanAvx2>,
+                    manyAvx2<double, chebyshevAvx2>,
+                    manyAvx2<float, squaredEuclideanAvx2>, manyAvx2<float, manhattanAvx2>,
+                    manyAvx2<float, chebyshevAvx2>,
+                    accumulateScaledAvx2, accumulateScaledAvx2,
+                    dotProductsAvx2};
+        case Isa::SSE2:
+            return {isa,
+                    squaredEuclideanSse2, manhattanSse2, chebyshevSse2,
+                    squaredEuclideanSse2, manhattanSse2, chebyshevSse2,
+                    accumulateSquaredSse2, accumulateAbsSse2, accumulateMaxAbsSse2,
+                    accumulateSquaredSse2, accumulateAbsSse2, accumulateMaxAbsSse2,
+                    manySse2<double, squaredEuclideanSse2>, manySse2<double, manhattanSse2>,
+                    manySse2<double, chebyshevSse2>,
+                    manySse2<float, squaredEuclideanSse2>, manySse2<float, manhattanSse2>,
+                    manySse2<float, chebyshevSse2>,
+                    accumulateScaledSse2, accumulateScaledSse2,
+                    dotProductsSse2};
+#endif
+        default:
+            return {Isa::SCALAR,
+                    squaredEuclideanScalarD, manhattanScalarD, chebyshevScalarD,
+                    squaredEuclideanScalarF, manhattanScalarF, chebyshevScalarF,
+                    accumulateSquaredScalar<double>, accumulateAbsScalar<double>,
+                    accumulateMaxAbsScalar<double>,
+                    accumulateSquaredScalar<float>, accumulateAbsScalar<float>,
+                    accumulateMaxAbsScalar<float>,
+                    manyScalar<double, squaredEuclideanScalar<double>>,
+                    manyScalar<double, manhattanScalar<double>>,
+                    manyScalar<double, chebyshevScalar<double>>,
+                    manyScalar<float, squaredEuclideanScalar<float>>,
+                    manyScalar<float, manhattanScalar<float>>,
+                    manyScalar<float, chebyshevScalar<float>>,
+                    accumulateScaledScalar<double>, accumulateScaledScalar<float>,
+                    dotProductsScalarD};
+    }
+}
+
+Isa detect() {
+#ifdef KNN_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return Isa::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return Isa::AVX2;
+    if (__builtin_cpu_supports("sse2")) return Isa::SSE2;
+#endif
+    return Isa::SCALAR;
+}
+
+// Selected on first use, so kernels work during static initialization too
+Table& table() {
+    static Table active = makeTable(detectedIsa());
+    return active;
+}
+
+} // namespace
+
+Isa detectedIsa() {
+    static const Isa isa = detect();
+    return isa;
+}
+
+Isa activeIsa() {
+    return table().isa;
+}
+
+const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX512: return "avx512";
+        case Isa::AVX2: return "avx2";
+        case Isa::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+bool setIsa(Isa isa) {
+    if (static_cast<int>(isa) > static_cast<int>(detectedIsa())) {
+        return false;
+    }
+    table() = makeTable(isa);
+    return true;
+}
+
+double squaredEuclidean(const double* a, const double* b, size_t n) {
+    return table().squaredEuclideanD(a, b, n);
+}
+
+double manhattan(const double* a, const double* b, size_t n) {
+    return table().manhattanD(a, b, n);
+}
+
+double chebyshev(const double* a, const double* b, size_t n) {
+    return table().chebyshevD(a, b, n);
+}
+
+float squaredEuclidean(const float* a, const float* b, size_t n) {
+    return table().squaredEuclideanF(a, b, n);
+}
+
+float manhattan(const float* a, const float* b, size_t n) {
+    return table().manhattanF(a, b, n);
+}
+
+float chebyshev(const float* a, const float* b, size_t n) {
+    return table().chebyshevF(a, b, n);
+}
+
+void accumulateSquared(const double* x, double q, double* out, size_t n) {
+    table().accumulateSquaredD(x, q, out, n);
+}
+
+void accumulateAbs(const double* x, double q, double* out, size_t n) {
+    table().accumulateAbsD(x, q, out, n);
+}
+
+void accumulateMaxAbs(const double* x, double q, double* out, size_t n) {
+    table().accumulateMaxAbsD(x, q, out, n);
+}
+
+void accumulateSquared(const float* x, float q, float* out, size_t n) {
+    table().accumulateSquaredF(x, q, out, n);
+}
+
+void accumulateAbs(const float* x, float q, float* out, size_t n) {
+    table().accumulateAbsF(x, q, out, n);
+}
+
+void accumulateMaxAbs(const float* x, float q, float* out, size_t n) {
+    table().accumulateMaxAbsF(x, q, out, n);
+}
+
+void squaredEuclideanMany(const double* query, const double* rows, size_t count, size_t dims,
+                          double* out) {
+    table().squaredEuclideanManyD(query, rows, count, dims, out);
+}
+
+void manhattanMany(const double* query, const double* rows, size_t count, size_t dims,
+                   double* out) {
+    table().manhattanManyD(query, rows, count, dims, out);
+}
+
+void chebyshevMany(const double* query, const double* rows, size_t count, size_t dims,
+                   double* out) {
+    table().chebyshevManyD(query, rows, count, dims, out);
+}
+
+void squaredEuclideanMany(const float* query, const float* rows, size_t count, size_t dims,
+                          float* out) {
+    table().squaredEuclideanManyF(query, rows, count, dims, out);
+}
+
+void manhattanMany(const float* query, const float* rows, size_t count, size_t dims,
+                   float* out) {
+    table().manhattanManyF(query, rows, count, dims, out);
+}
+
+void chebyshevMany(const float* query, const float* rows, size_t count, size_t dims,
+                   float* out) {
+    table().chebyshevManyF(query, rows, count, dims, out);
+}
+
+void accumulateScaled(const double* x, double s, double* out, size_t n) {
+    table().accumulateScaledD(x, s, out, n);
+}
+
+void accumulateScaled(const float* x, float s, float* out, size_t n) {
+    table().accumulateScaledF(x, s, out, n);
+}
+
+void dotProducts(const double* const* queries, const double* x, size_t stride, size_t dims,
+                 double* out, size_t n) {
+    table().dotProductsD(queries, x, stride, dims, out, n);
+}
+
+} // namespace DistanceKernels
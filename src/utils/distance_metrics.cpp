@@ -1,4 +1,6 @@
 #include "../../include/utils/distance_metrics.h"
+#include "../../include/utils/distance_kernels.h"
+#include "../../include/utils/metric_policies.h"
 #include <cmath>
 #include <algorithm>
 
@@ -22,29 +24,17 @@ double euclidean(const Point& a, const Point& b) {
 
 double euclidean(const std::vector<double>& a, const std::vector<double>& b) {
     // Note: Don't increment here, already counted in Point version
-    double sum = 0;
-    for (size_t i = 0; i < a.size(); i++) {
-        double diff = a[i] - b[i];
-        sum += diff * diff;
-    }
-    return std::sqrt(sum);
+    return std::sqrt(DistanceKernels::squaredEuclidean(a.data(), b.data(), a.size()));
 }
 
 double manhattan(const Point& a, const Point& b) {
-    double sum = 0;
-    for (size_t i = 0; i < a.coordinates.size(); i++) {
-        sum += std::abs(a.coordinates[i] - b.coordinates[i]);
-    }
-    return sum;
+    return DistanceKernels::manhattan(a.coordinates.data(), b.coordinates.data(),
+                                      a.coordinates.size());
 }
 
 double chebyshev(const Point& a, const Point& b) {
-    double maxDiff = 0;
-    for (size_t i = 0; i < a.coordinates.size(); i++) {
-        double diff = std::abs(a.coordinates[i] - b.coordinates[i]);
-        maxDiff = std::max(maxDiff, diff);
-    }
-    return maxDiff;
+    return DistanceKernels::chebyshev(a.coordinates.data(), b.coordinates.data(),
+                                      a.coordinates.size());
 }
 
 double minkowski(const Point& a, const Point& b, double p) {
@@ -65,4 +55,47 @@ double hamming(const Point& a, const Point& b) {
     return count;
 }
 
+double reducedDistance(const Point& a, const Point& b, DistanceType type, double p) {
+    return reducedDistance(a.coordinates.data(), b.coordinates.data(),
+                           a.coordinates.size(), type, p);
+}
+
+double reducedDistance(const double* a, const double* b, size_t dims,
+                       DistanceType type, double p) {
+    return MetricPolicy::withMetric(type, p, [&](const auto& metric) {
+        return metric.reduced(a, b, dims);
+    });
+}
+
+void reducedDistances(const double* query, const double* rows, size_t count, size_t dims,
+                      DistanceType type, double p, double* out) {
+    MetricPolicy::withMetric(type, p, [&](const auto& metric) {
+        metric.reducedMany(query, rows, count, dims, out);
+    });
+}
+
+double reducedAxisDistance(double diff, DistanceType type, double p) {
+    return MetricPolicy::withMetric(type, p, [&](const auto& metric) {
+        return metric.axis(diff);
+    });
+}
+
+double combineAxisDistances(double bound, double axisBound, DistanceType type) {
+    return MetricPolicy::withMetric(type, 2.0, [&](const auto& metric) {
+        return metric.combine(bound, axisBound);
+    });
+}
+
+double reducedToDistance(double reduced, DistanceType type, double p) {
+    return MetricPolicy::withMetric(type, p, [&](const auto& metric) {
+        return metric.toDistance(reduced);
+    });
+}
+
+double distanceToReduced(double distance, DistanceType type, double p) {
+    return MetricPolicy::withMetric(type, p, [&](const auto& metric) {
+        return metric.toReduced(distance);
+    });
+}
+
 } // namespace DistanceMetrics
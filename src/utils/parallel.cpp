@@ -0,0 +1,102 @@
+#include "../../include/utils/parallel.h"
+#include <condition_variable>
+#include <cstdint>
+
+namespace Parallel {
+
+namespace {
+
+thread_local bool onPoolWorker = false;
+
+// Workers are started on first use, as many as the largest call has asked
+// for, and sleep on a condition variable between calls. A call publishes
+// its task under a new generation number; workers whose id is below the
+// call's thread count run it, the others go back to sleep.
+class Pool {
+private:
+    std::mutex owner;                   // held by the call using the pool
+    std::mutex mutex;                   // guards the fields below
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::vector<std::thread> workers;   // worker t - 1 runs task(t)
+    const std::function<void(int)>* task = nullptr;
+    uint64_t generation = 0;
+    int active = 0;                     // threads of the current call
+    int pending = 0;                    // its workers still running
+    bool stopping = false;
+
+    void loop(int id) {
+        onPoolWorker = true;
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            if (id >= active) continue;
+
+            const std::function<void(int)>* current = task;
+            lock.unlock();
+            (*current)(id);
+            lock.lock();
+            if (--pending == 0) done.notify_one();
+        }
+    }
+
+public:
+    ~Pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    bool run(int threads, const std::function<void(int)>& work) {
+        if (onPoolWorker) return false;
+        std::unique_lock<std::mutex> busy(owner, std::try_to_lock);
+        if (!busy.owns_lock()) return false;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            while (static_cast<int>(workers.size()) < threads - 1) {
+                int id = static_cast<int>(workers.size()) + 1;
+                workers.emplace_back(&Pool::loop, this, id);
+            }
+            task = &work;
+            active = threads;
+            pending = threads - 1;
+            generation++;
+        }
+        wake.notify_all();
+
+        // The workers hold a pointer to work until they are done with it
+        std::exception_ptr error;
+        try {
+            work(0);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+        task = nullptr;
+        if (error) std::rethrow_exception(error);
+        return true;
+    }
+};
+
+Pool& pool() {
+    static Pool instance;
+    return instance;
+}
+
+} // namespace
+
+bool runOnPool(int threads, const std::function<void(int)>& work) {
+    return pool().run(threads, work);
+}
+
+} // namespace Parallel
@@ -0,0 +1,350 @@
+#include <iostream>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <random>
+#include <cstdio>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include "../include/utils/point.h"
+#include "../include/utils/dataset.h"
+#include "../include/utils/dataset_loader.h"
+#include "../include/utils/dataset_cache.h"
+#include "../include/utils/binary_file.h"
+#include "../include/knn/knn_basic.h"
+
+void testDatasetRows() {
+    std::cout << "\n=== Test 1: Contiguous Dataset and Row Views ===" << std::endl;
+
+    auto points = DatasetLoader::generateRandom(2000, 4, 51);
+    for (size_t i = 0; i < points.size(); i++) points[i].label = static_cast<int>(i % 3);
+
+    Dataset data = Dataset::fromPoints(points);
+    assert(data.size() == points.size() && data.dimensions() == 4);
+    assert(data.rowData(1) == data.rowData(0) + 4);
+    for (size_t i = 0; i < points.size(); i++) {
+        assert(data.label(i) == points[i].label);
+        assert(data.row(i).toPoint().coordinates == points[i].coordinates);
+    }
+
+    data.buildColumnMajor();
+    assert(data.hasColumnMajor());
+    assert(data.column(2)[7] == points[7][2]);
+    std::cout << " Row-major and column-major layouts match the points" << std::endl;
+
+    // CSV rows parse straight into the matrix
+    const char* path = "dataset_rows_test.csv";
+    {
+        std::ofstream out(path);
+        out << "x,y,label\n1.5,2.0,0\n3.0,-4.25,1\n\n5.0,6.0,1\n";
+    }
+    Dataset loaded = DatasetLoader::loadCSVDataset(path);
+    auto loadedPoints = DatasetLoader::loadCSV(path);
+    std::remove(path);
+    assert(loaded.size() == 3 && loaded.dimensions() == 2);
+    for (size_t i = 0; i < loaded.size(); i++) {
+        assert(loaded.row(i).toPoint().coordinates == loadedPoints[i].coordinates);
+        assert(loaded.label(i) == loadedPoints[i].label);
+    }
+    std::cout << " loadCSVDataset matches loadCSV" << std::endl;
+
+    bool threw = false;
+    try {
+        data.addRow(Point({1.0, 2.0}));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << " Rows of the wrong dimension are rejected" << std::endl;
+}
+
+void testBinaryFiles() {
+    std::cout << "\n=== Test 2: Binary File Layout ===" << std::endl;
+
+    const char magic[8] = {'T', 'E', 'S', 'T', 'F', 'I', 'L', 'E'};
+    const char otherMagic[8] = {'T', 'E', 'S', 'T', 'F', 'I', 'L', 'X'};
+    BinaryFile::Preamble preamble = BinaryFile::makePreamble(magic, 3);
+    assert(BinaryFile::checkPreamble(preamble, magic, 3) == BinaryFile::PreambleCheck::OK);
+    assert(BinaryFile::checkPreamble(preamble, magic, 4) == BinaryFile::PreambleCheck::WRONG_VERSION);
+    assert(BinaryFile::checkPreamble(preamble, otherMagic, 3) == BinaryFile::PreambleCheck::WRONG_MAGIC);
+    BinaryFile::Preamble swapped = preamble;
+    swapped.byteOrder = 0x04030201;
+    assert(BinaryFile::checkPreamble(swapped, magic, 3) == BinaryFile::PreambleCheck::WRONG_BYTE_ORDER);
+    std::cout << " Preambles of other formats, versions and byte orders are told apart" << std::endl;
+
+    // Sections start on aligned offsets after the header, padding is zero
+    struct Header {
+        BinaryFile::Preamble preamble;
+        uint64_t textOffset;
+        uint64_t valuesOffset;
+    };
+    assert(BinaryFile::alignedOffset(0) == 0 && BinaryFile::alignedOffset(1) == 64);
+    assert(BinaryFile::alignedOffset(64) == 64 && BinaryFile::alignedOffset(65, 8) == 72);
+
+    const char* path = "binary_file_test.bin";
+    const double values[3] = {1.5, -2.0, 4.25};
+    Header header = {preamble, 0, 0};
+    {
+        BinaryFile::SectionWriter writer(path, sizeof(Header));
+        assert(writer.isOpen());
+        header.textOffset = writer.write("abc", 3);
+        header.valuesOffset = writer.write(values, sizeof(values), sizeof(double));
+        assert(writer.size() == header.valuesOffset + sizeof(values));
+        assert(writer.finish(&header, sizeof(Header)));
+    }
+    assert(header.textOffset == 64 && header.valuesOffset == 72);
+
+    std::ifstream in(path, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::remove(path);
+    assert(bytes.size() == 72 + sizeof(values));
+    Header readBack;
+    std::memcpy(&readBack, bytes.data(), sizeof(Header));
+    assert(BinaryFile::checkPreamble(readBack.preamble, magic, 3) == BinaryFile::PreambleCheck::OK);
+    assert(readBack.textOffset == 64 && readBack.valuesOffset == 72);
+    assert(std::all_of(bytes.begin() + sizeof(Header), bytes.begin() + 64, [](char c) { return c == 0; }));
+    assert(std::string(bytes.data() + 64, 3) == "abc");
+    assert(std::memcmp(bytes.data() + 72, values, sizeof(values)) == 0);
+    std::cout << " Sections are written at aligned offsets the header records" << std::endl;
+}
+
+void testDatasetCache() {
+    std::cout << "\n=== Test 3: Binary Dataset Cache ===" << std::endl;
+
+    const char* path = "dataset_cache_test.csv";
+    const char* cache = "dataset_cache_test.csv.cache";
+    {
+        std::ofstream out(path);
+        out << "color,x,y,kind\nred,1.5,2.0,cat\nblue,3.0,-4.25,dog\ngreen,0.1,7.0,cat\n"
+               "red,5.0,6.0,bird\n";
+    }
+    std::remove(cache);
+
+    // First load parses and writes the cache, the second reads it back
+    DatasetCache::Encoding parsedEncoding;
+    Dataset parsed = DatasetLoader::loadCSVCached(path, true, -1, true, "", &parsedEncoding);
+    std::ifstream written(cache, std::ios::binary);
+    assert(written.good());
+    written.close();
+    DatasetCache::Encoding cachedEncoding;
+    Dataset cached = DatasetLoader::loadCSVCached(path, true, -1, true, "", &cachedEncoding);
+
+    auto expected = DatasetLoader::loadCSVWithEncoding(path, true, {}, -1);
+    assert(parsed.size() == expected.size() && cached.size() == expected.size());
+    assert(cached.dimensions() == 5);
+    for (size_t i = 0; i < expected.size(); i++) {
+        assert(parsed.row(i).toPoint().coordinates == expected[i].coordinates);
+        assert(cached.row(i).toPoint().coordinates == expected[i].coordinates);
+        assert(cached.label(i) == expected[i].label);
+    }
+    assert(cachedEncoding.columns == std::vector<int>({0}));
+    assert(cachedEncoding.categories == parsedEncoding.categories);
+    assert(cachedEncoding.categories[0] == std::vector<std::string>({"blue", "green", "red"}));
+    assert(cachedEncoding.labelCategories == std::vector<std::string>({"bird", "cat", "dog"}));
+    std::cout << " Cached rows, labels and encoding match a fresh parse" << std::endl;
+
+    // The cache only serves the options and source file it was written for
+    const char* cacheKey = "DatasetLoader::loadCSV header=1 label=-1 encode=1";
+    DatasetCache::Source source = DatasetCache::source(path);
+    assert(source.checksum == 0);
+    Dataset other;
+    assert(DatasetCache::load(cache, cacheKey, source, other));
+    assert(!DatasetCache::load(cache, "other options", source, other));
+    DatasetCache::Source touched = source;
+    touched.modified++;
+    assert(!DatasetCache::load(cache, cacheKey, touched, other));
+    DatasetCache::Source verified = DatasetCache::source(path, true);
+    assert(DatasetCache::load(cache, cacheKey, verified, other));
+    verified.checksum++;
+    assert(!DatasetCache::load(cache, cacheKey, verified, other));
+
+    // A rewrite that keeps size and modification time is only caught by
+    // the opt-in checksum
+    {
+        std::ofstream out(path);
+        out << "color,x,y,kind\nred,1.5,2.0,cat\nblue,3.0,-4.25,dog\ngreen,0.1,8.0,cat\n"
+               "red,5.0,6.0,bird\n";
+    }
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type(
+        std::filesystem::file_time_type::duration(source.modified)));
+    assert(DatasetLoader::loadCSVCached(path, true, -1, true).rowData(2)[4] == 7.0);
+    assert(DatasetLoader::loadCSVCached(path, true, -1, true, "", nullptr, true).rowData(2)[4] == 8.0);
+
+    {
+        std::ofstream out(path, std::ios::app);
+        out << "blue,9.0,9.0,dog\n";
+    }
+    Dataset edited = DatasetLoader::loadCSVCached(path, true, -1, true);
+    assert(edited.size() == 5 && edited.rowData(4)[3] == 9.0);
+    {
+        std::ofstream out(cache, std::ios::binary | std::ios::app);
+        out << "trailing bytes";
+    }
+    assert(!DatasetCache::load(cache, cacheKey, DatasetCache::source(path), other));
+    std::remove(path);
+    std::remove(cache);
+    std::cout << " Other options, edited sources and damaged caches are not used" << std::endl;
+}
+
+void testParallelCSV() {
+    std::cout << "\n=== Test 4: Parallel CSV Parsing ===" << std::endl;
+
+    // Cells parse as std::stod would; text, empty and ragged rows are skipped
+    const char* path = "parallel_csv_test.csv";
+    {
+        std::ofstream out(path);
+        out << "a,b,label\n 1.5 , +2 ,3\r\n\n4,abc,5,6\n-1e3,0x10,7\n1,2\n,,\n.5,-0.25,1\n";
+    }
+    Dataset cells = DatasetLoader::loadCSVDataset(path, true, -1, 1);
+    assert(cells.size() == 4 && cells.dimensions() == 2);
+    assert(cells.rowData(0)[0] == 1.5 && cells.rowData(0)[1] == 2.0 && cells.label(0) == 3);
+    assert(cells.rowData(1)[0] == 4.0 && cells.rowData(1)[1] == 5.0 && cells.label(1) == 6);
+    assert(cells.rowData(2)[0] == -1000.0 && cells.rowData(2)[1] == 16.0 && cells.label(2) == 7);
+    assert(cells.rowData(3)[0] == 0.5 && cells.rowData(3)[1] == -0.25 && cells.label(3) == 1);
+    auto points = DatasetLoader::loadCSV(path);
+    assert(points.size() == 5 && points[3].coordinates == std::vector<double>({1.0}));
+    std::cout << " Cells are trimmed and parsed in place; bad rows are skipped" << std::endl;
+
+    // A file of several chunks parses the same on any number of workers
+    {
+        std::ofstream out(path);
+        out << "x,y,z,label\n";
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> dist(-100.0, 100.0);
+        for (int i = 0; i < 150000; i++) {
+            if (i % 1000 == 999) out << "\n1,2\n";
+            out << dist(rng) << "," << dist(rng) << "," << static_cast<int>(dist(rng)) << ","
+                << i % 5 << "\n";
+        }
+    }
+    Dataset serial = DatasetLoader::loadCSVDataset(path, true, -1, 1);
+    assert(serial.size() == 150000 && serial.dimensions() == 3);
+    for (int threads : {2, 5, 16}) {
+        Dataset parallel = DatasetLoader::loadCSVDataset(path, true, -1, threads);
+        assert(parallel.size() == serial.size());
+        assert(std::equal(serial.data(), serial.data() + serial.size() * 3, parallel.data()));
+        assert(parallel.labels() == serial.labels());
+    }
+    std::remove(path);
+    std::cout << " Chunked parsing matches a single worker, rows in file order" << std::endl;
+}
+
+void testStreamingKNN() {
+    std::cout << "\n=== Test 5: Streaming Chunks and Out-of-Core k-NN ===" << std::endl;
+
+    const char* path = "streaming_knn_test.csv";
+    {
+        std::ofstream out(path);
+        out << "x,y,z,label\n";
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<double> dist(-50.0, 50.0);
+        for (int i = 0; i < 2000; i++) {
+            if (i == 500) out << "1,2\n\n";
+            out << dist(rng) << "," << dist(rng) << "," << dist(rng) << "," << i % 4 << "\n";
+        }
+    }
+    Dataset all = DatasetLoader::loadCSVDataset(path);
+    assert(all.size() == 2000);
+
+    // Chunks of at most chunkRows rows, in file order, ragged rows skipped
+    CSVChunkReader reader(path, 300);
+    Dataset chunk;
+    size_t rows = 0;
+    while (reader.next(chunk)) {
+        assert(chunk.size() <= 300 && chunk.dimensions() == 3);
+        assert(std::equal(chunk.data(), chunk.data() + chunk.size() * 3, all.rowData(rows)));
+        rows += chunk.size();
+        assert(reader.position() == rows);
+    }
+    assert(rows == all.size() && !reader.next(chunk));
+    reader.rewind();
+    assert(reader.next(chunk) && reader.position() == 300 &&
+           chunk.rowData(0)[0] == all.rowData(0)[0]);
+    std::cout << " Chunks cover every loaded row once; rewind restarts the file" << std::endl;
+
+    Dataset queries(3);
+    for (size_t i = 0; i < 40; i++) {
+        queries.addRow(all.rowData(i * 37), -1);
+        double shifted[3] = {all.rowData(i)[0] + 0.5, -all.rowData(i)[1], 3.0};
+        queries.addRow(shifted, -1);
+    }
+
+    // Top-k carried across chunks equals a scan of the data in memory
+    for (Precision precision : {Precision::FLOAT64, Precision::FLOAT32, Precision::MIXED}) {
+        for (DistanceType metric : {DistanceType::EUCLIDEAN, DistanceType::MANHATTAN,
+                                    DistanceType::CHEBYSHEV}) {
+            KNNBasic memory(7, metric, 2.0, precision);
+            memory.fit(all);
+            KNNBasic streaming(7, metric, 2.0, precision);
+            streaming.fitStream(path, 128);
+            assert(streaming.isStreaming() && !memory.isStreaming());
+
+            auto streamed = streaming.findKNearestIndicesBatch(queries, 3);
+            auto batched = memory.findKNearestIndicesBatch(queries, 2);
+            std::vector<int> predictions = streaming.predictBatch(queries);
+            for (size_t q = 0; q < queries.size(); q++) {
+                auto expected = memory.findKNearestIndices(queries.row(q));
+                assert(streamed[q].size() == expected.size());
+                for (size_t j = 0; j < expected.size(); j++) {
+                    assert(streamed[q][j].index == expected[j].index);
+                    assert(streamed[q][j].distance == expected[j].distance);
+                    assert(batched[q][j].index == expected[j].index);
+                }
+                assert(predictions[q] == memory.predict(queries.row(q)));
+                assert(streaming.predict(queries.row(q)) == predictions[q]);
+            }
+        }
+    }
+    std::cout << " Streamed neighbors and votes match the in-memory search" << std::endl;
+
+    KNNBasic streaming(3);
+    streaming.fitStream(path, 64);
+    assert(streaming.predictWithMetrics(queries.row(0)).distance_calculations == 2000);
+    bool threw = false;
+    try {
+        streaming.findKNearest(Point({0.0, 0.0, 0.0}));
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        streaming.predictBatch(Dataset(2, 2));
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::remove(path);
+    std::cout << " Point results need memory; mismatched queries are rejected" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "      DATASET AND LOADER TEST SUITE     " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    try {
+        testDatasetRows();
+        testBinaryFiles();
+        testDatasetCache();
+        testParallelCSV();
+        testStreamingKNN();
+
+        std::cout << "\n========================================" << std::endl;
+        std::cout << "    ALL TESTS PASSED SUCCESSFULLY!" << std::endl;
+        std::cout << "========================================\n" << std::endl;
+
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "\nTEST FAILED: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "\nTEST FAILED: Unknown error" << std::endl;
+        return 1;
+    }
+}
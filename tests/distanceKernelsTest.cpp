@@ -0,0 +1,227 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <type_traits>
+#include "../include/kdtree/kdtree.h"
+#include "../include/utils/point.h"
+#include "../include/utils/dataset_loader.h"
+#include "../include/utils/distance_kernels.h"
+#include "../include/utils/distance_metrics.h"
+#include "../include/utils/metric_policies.h"
+
+void testDistanceKernels() {
+    std::cout << "\n=== Test 1: SIMD Distance Kernels ===" << std::endl;
+    using namespace DistanceKernels;
+
+    const Isa detected = detectedIsa();
+    std::cout << " Detected instruction set: " << isaName(detected) << std::endl;
+
+    // Odd lengths exercise the vector tails
+    std::vector<double> a(37), b(37), column(37), acc(37);
+    std::vector<float> af(37), bf(37), columnf(37), accf(37);
+    for (size_t i = 0; i < a.size(); i++) {
+        a[i] = std::sin(0.7 * i) * 3.0;
+        b[i] = std::cos(1.3 * i) * 2.0;
+        af[i] = static_cast<float>(a[i]);
+        bf[i] = static_cast<float>(b[i]);
+    }
+
+    auto points = DatasetLoader::generateRandom(3000, 6, 61);
+    auto queries = DatasetLoader::generateRandom(50, 6, 62);
+
+    std::vector<std::vector<Neighbor>> reference;
+    for (Isa isa : {Isa::SCALAR, Isa::SSE2, Isa::AVX2, Isa::AVX512}) {
+        if (!setIsa(isa)) {
+            assert(static_cast<int>(isa) > static_cast<int>(detected));
+            continue;
+        }
+        assert(activeIsa() == isa);
+
+        for (size_t n = 0; n <= a.size(); n++) {
+            double l2 = 0, l1 = 0, linf = 0;
+            for (size_t i = 0; i < n; i++) {
+                double diff = a[i] - b[i];
+                l2 += diff * diff;
+                l1 += std::abs(diff);
+                linf = std::max(linf, std::abs(diff));
+            }
+            assert(std::abs(squaredEuclidean(a.data(), b.data(), n) - l2) < 1e-9);
+            assert(std::abs(manhattan(a.data(), b.data(), n) - l1) < 1e-9);
+            assert(chebyshev(a.data(), b.data(), n) == linf);
+            assert(std::abs(squaredEuclidean(af.data(), bf.data(), n) - l2) < 1e-3);
+            assert(std::abs(manhattan(af.data(), bf.data(), n) - l1) < 1e-3);
+            assert(std::abs(chebyshev(af.data(), bf.data(), n) - linf) < 1e-5);
+
+            std::fill(acc.begin(), acc.end(), 1.0);
+            accumulateSquared(a.data(), 0.5, acc.data(), n);
+            for (size_t i = 0; i < acc.size(); i++) {
+                double expected = 1.0 + (i < n ? (a[i] - 0.5) * (a[i] - 0.5) : 0.0);
+                assert(std::abs(acc[i] - expected) < 1e-12);
+            }
+            std::fill(acc.begin(), acc.end(), 1.0);
+            accumulateAbs(a.data(), 0.5, acc.data(), n);
+            accumulateMaxAbs(a.data(), -0.5, acc.data(), n);
+            for (size_t i = 0; i < acc.size(); i++) {
+                double expected = 1.0;
+                if (i < n) {
+                    expected = std::max(1.0 + std::abs(a[i] - 0.5), std::abs(a[i] + 0.5));
+                }
+                assert(std::abs(acc[i] - expected) < 1e-12);
+            }
+            std::fill(acc.begin(), acc.end(), 1.0);
+            accumulateScaled(a.data(), -2.0, acc.data(), n);
+            for (size_t i = 0; i < acc.size(); i++) {
+                assert(std::abs(acc[i] - (1.0 - (i < n ? 2.0 * a[i] : 0.0))) < 1e-12);
+            }
+            std::fill(accf.begin(), accf.end(), 0.0f);
+            accumulateSquared(af.data(), 0.5f, accf.data(), n);
+            accumulateAbs(af.data(), 0.5f, accf.data(), n);
+            for (size_t i = 0; i < n; i++) {
+                double diff = af[i] - 0.5;
+                assert(std::abs(accf[i] - (diff * diff + std::abs(diff))) < 1e-4);
+            }
+        }
+
+        // One-to-many kernels agree with the row kernels for every row
+        for (size_t dims = 1; dims <= 19; dims++) {
+            size_t count = a.size() / dims;
+            std::vector<double> out(count);
+            std::vector<float> outf(count);
+            squaredEuclideanMany(b.data(), a.data(), count, dims, out.data());
+            squaredEuclideanMany(bf.data(), af.data(), count, dims, outf.data());
+            for (size_t r = 0; r < count; r++) {
+                assert(std::abs(out[r] - squaredEuclidean(b.data(), a.data() + r * dims, dims)) < 1e-12);
+                assert(std::abs(outf[r] - squaredEuclidean(bf.data(), af.data() + r * dims, dims)) < 1e-4);
+            }
+            manhattanMany(b.data(), a.data(), count, dims, out.data());
+            for (size_t r = 0; r < count; r++) {
+                assert(std::abs(out[r] - manhattan(b.data(), a.data() + r * dims, dims)) < 1e-12);
+            }
+            chebyshevMany(b.data(), a.data(), count, dims, out.data());
+            for (size_t r = 0; r < count; r++) {
+                assert(out[r] == chebyshev(b.data(), a.data() + r * dims, dims));
+            }
+            for (DistanceType type : {DistanceType::EUCLIDEAN, DistanceType::MANHATTAN,
+                                      DistanceType::HAMMING, DistanceType::MINKOWSKI,
+                                      DistanceType::CHEBYSHEV}) {
+                DistanceMetrics::reducedDistances(b.data(), a.data(), count, dims, type, 3.0, out.data());
+                for (size_t r = 0; r < count; r++) {
+                    double expected = DistanceMetrics::reducedDistance(b.data(), a.data() + r * dims,
+                                                                       dims, type, 3.0);
+                    assert(std::abs(out[r] - expected) < 1e-9);
+                }
+            }
+        }
+
+        // Blocked dot products: a as an axis-major block of n columns, the
+        // queries taken from b; every column count exercises the tails
+        for (size_t n = 1; n <= 18; n++) {
+            size_t dims = a.size() / n;
+            const double* rowsOf[DOT_QUERIES] = {b.data(), b.data() + 3, a.data() + 1, b.data() + 1};
+            std::vector<double> out(DOT_QUERIES * n);
+            dotProducts(rowsOf, a.data(), n, dims, out.data(), n);
+            for (size_t i = 0; i < DOT_QUERIES; i++) {
+                for (size_t j = 0; j < n; j++) {
+                    double expected = 0;
+                    for (size_t d = 0; d < dims; d++) expected += rowsOf[i][d] * a[d * n + j];
+                    assert(std::abs(out[i * n + j] - expected) < 1e-9);
+                }
+            }
+        }
+
+        // Leaf scans route through the kernels; results must not depend on the ISA
+        KDTree tree(6);
+        tree.build(points);
+        std::vector<std::vector<Neighbor>> found;
+        for (const auto& q : queries) {
+            found.push_back(tree.kNearestNeighborIndices(q, 5));
+        }
+        if (reference.empty()) {
+            reference = found;
+        }
+        for (size_t i = 0; i < found.size(); i++) {
+            for (size_t j = 0; j < found[i].size(); j++) {
+                assert(found[i][j].index == reference[i][j].index);
+                assert(std::abs(found[i][j].distance - reference[i][j].distance) < 1e-9);
+            }
+        }
+        std::cout << " " << isaName(isa) << " kernels match the scalar reference" << std::endl;
+    }
+
+    setIsa(detected);
+}
+
+void testMetricPolicies() {
+    std::cout << "\n=== Test 2: Compile-time Metric Policies ===" << std::endl;
+    using namespace MetricPolicy;
+
+    // The factory picks the policy type; small integer Minkowski exponents
+    // get their own instantiation
+    auto isMinkowski3 = withMetric(DistanceType::MINKOWSKI, 3.0, [](const auto& metric) {
+        return std::is_same<std::decay_t<decltype(metric)>, Minkowski<3>>::value;
+    });
+    assert(isMinkowski3);
+    double reduced = withMetric(DistanceType::MINKOWSKI, 2.5, [](const auto& metric) {
+        return metric.toReduced(2.0);
+    });
+    assert(std::abs(reduced - std::pow(2.0, 2.5)) < 1e-12);
+    for (DistanceType type : {DistanceType::EUCLIDEAN, DistanceType::MANHATTAN,
+                              DistanceType::HAMMING, DistanceType::CHEBYSHEV}) {
+        assert(withMetric(type, 2.0, [](const auto& metric) { return metric.type; }) == type);
+    }
+    std::cout << " Factory maps DistanceType to policies" << std::endl;
+
+    // Policies agree with the Point-based metrics
+    auto data = DatasetLoader::generateRandom(50, 7, 61);
+    for (size_t i = 1; i < data.size(); i++) {
+        const double* a = data[i - 1].coordinates.data();
+        const double* b = data[i].coordinates.data();
+        const Point& pa = data[i - 1];
+        const Point& pb = data[i];
+        assert(std::abs(Euclidean().toDistance(Euclidean().reduced(a, b, 7)) -
+                        DistanceMetrics::euclidean(pa, pb)) < 1e-9);
+        assert(std::abs(Manhattan().reduced(a, b, 7) - DistanceMetrics::manhattan(pa, pb)) < 1e-9);
+        assert(Chebyshev().reduced(a, b, 7) == DistanceMetrics::chebyshev(pa, pb));
+        assert(Hamming().reduced(a, b, 7) == DistanceMetrics::hamming(pa, pb));
+        assert(std::abs(Minkowski<3>().toDistance(Minkowski<3>().reduced(a, b, 7)) -
+                        DistanceMetrics::minkowski(pa, pb, 3.0)) < 1e-9);
+        assert(std::abs(Minkowski<3>().reduced(a, b, 7) - Minkowski<>(3.0).reduced(a, b, 7)) < 1e-6);
+        assert(std::abs(Minkowski<2>().reduced(a, b, 7) - Euclidean().reduced(a, b, 7)) < 1e-9);
+    }
+    std::cout << " Policies match the reference distances" << std::endl;
+
+    // Chebyshev cell bounds take the maximum offset instead of the sum
+    assert(Chebyshev().replaceAxis(3.0, 1.0, -2.0) == 3.0);
+    assert(Chebyshev().replaceAxis(3.0, 1.0, 5.0) == 5.0);
+    assert(Euclidean().replaceAxis(5.0, 1.0, 2.0) == 8.0);
+    assert(DistanceMetrics::combineAxisDistances(2.0, 1.5, DistanceType::CHEBYSHEV) == 2.0);
+    assert(DistanceMetrics::combineAxisDistances(2.0, 1.5, DistanceType::MANHATTAN) == 3.5);
+    std::cout << " Axis bounds combine per metric" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "      DISTANCE KERNELS TEST SUITE       " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    try {
+        testDistanceKernels();
+        testMetricPolicies();
+
+        std::cout << "\n========================================" << std::endl;
+        std::cout << "    ALL TESTS PASSED SUCCESSFULLY!" << std::endl;
+        std::cout << "========================================\n" << std::endl;
+
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "\nTEST FAILED: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "\nTEST FAILED: Unknown error" << std::endl;
+        return 1;
+    }
+}
@@ -1,8 +1,22 @@
 #include <iostream>
 #include <cassert>
 #include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <cstdio>
+#include <fstream>
 #include "../include/kdtree/kdtree.h"
 #include "../include/utils/point.h"
+#include "../include/utils/dataset.h"
+#include "../include/utils/dataset_loader.h"
+#include "../include/utils/distance_metrics.h"
+#include "../include/utils/dimensions.h"
+#include "../include/utils/parallel.h"
+#include "../include/kdtree/node_arena.h"
+#include "../include/knn/knn_kdtree.h"
 
 void testInsertAndSearch() {
     std::cout << "\n=== Test 1: Insert and Search ===" << std::endl;
@@ -88,6 +102,25 @@ void testDelete() {
     assert(tree.search(p3) == true);
     std::cout << " Deleted internal node successfully" << std::endl;
 
+    // Replacements follow SUCCESSOR's superkey order, so ties on the
+    // discriminator and LOSON-only nodes keep every other point reachable
+    KDTree grid(2);
+    std::vector<Point> gridPoints;
+    for (int i = 0; i < 600; i++) {
+        int cell = (i * 7919) % 600;  // 20 x 30 grid in scrambled order
+        gridPoints.push_back(Point({static_cast<double>(cell % 20),
+                                    static_cast<double>(cell / 20)}, i % 2));
+    }
+    for (const auto& p : gridPoints) grid.insert(p);
+    for (size_t i = 0; i < gridPoints.size(); i += 3) {
+        grid.remove(gridPoints[i]);
+        assert(!grid.search(gridPoints[i]));
+    }
+    for (size_t i = 0; i < gridPoints.size(); i++) {
+        assert(grid.search(gridPoints[i]) == (i % 3 != 0));
+    }
+    std::cout << " Deletions with tied coordinates keep the other points" << std::endl;
+
     std::cout << "\nTree after deletions:" << std::endl;
     tree.inorder();
 }
@@ -257,6 +290,786 @@ void testEdgeCases() {
     std::cout << " Insert with wrong dimension correctly rejected" << std::endl;
 }
 
+void testBulkBuild() {
+    std::cout << "\n=== Test 7: Balanced Bulk Build ===" << std::endl;
+
+    // Sorted input degenerates a tree built by repeated INSERT
+    std::vector<Point> sorted;
+    for (int i = 0; i < 1023; i++) {
+        sorted.push_back(Point({static_cast<double>(i), static_cast<double>(i)}, i % 2));
+    }
+
+    KDTree inserted(2);
+    for (const auto& p : sorted) {
+        inserted.insert(p);
+    }
+
+    KDTree built(2, DistanceType::EUCLIDEAN, 2.0, 1);
+    built.build(sorted);
+
+    assert(inserted.height() == 1023);
+    assert(built.height() == 11);  // 10 split levels + leaf level
+    std::cout << " Height on sorted input: insert=" << inserted.height()
+              << ", build=" << built.height() << std::endl;
+
+    // Duplicates are dropped, as with INSERT
+    std::vector<Point> withDuplicates = sorted;
+    withDuplicates.push_back(sorted[5]);
+    KDTree deduped(2);
+    deduped.build(withDuplicates);
+    assert(deduped.kNearestNeighbors(sorted[5], 2000).size() == sorted.size());
+    std::cout << " Duplicate points dropped during build" << std::endl;
+
+    // Built tree supports SEARCH, INSERT and DELETE
+    for (const auto& p : sorted) {
+        assert(built.search(p) == true);
+    }
+    Point extra({0.5, 2000.0}, 1);
+    assert(built.insert(extra) == true);
+    assert(built.search(extra) == true);
+    built.remove(sorted[511]);
+    assert(built.search(sorted[511]) == false);
+    assert(built.search(sorted[510]) == true);
+    std::cout << " Search, insert and delete work on built tree" << std::endl;
+
+    // k-NN on a built tree matches a tree built by INSERT
+    auto data = DatasetLoader::generateRandom(2000, 4, 7);
+    KDTree a(4), b(4);
+    for (const auto& p : data) {
+        a.insert(p);
+    }
+    b.build(data);
+
+    auto queries = DatasetLoader::generateRandom(50, 4, 8);
+    for (const auto& q : queries) {
+        auto na = a.kNearestNeighbors(q, 5);
+        auto nb = b.kNearestNeighbors(q, 5);
+        assert(na.size() == nb.size());
+        for (size_t i = 0; i < na.size(); i++) {
+            assert(na[i].coordinates == nb[i].coordinates);
+            assert(na[i].label == nb[i].label);
+        }
+        assert(a.nearestNeighbor(q).coordinates == b.nearestNeighbor(q).coordinates);
+    }
+    std::cout << " k-NN results match insert-built tree" << std::endl;
+}
+
+void testLeafBuckets() {
+    std::cout << "\n=== Test 8: Bucketed Leaves ===" << std::endl;
+
+    auto data = DatasetLoader::generateRandom(3000, 3, 11);
+    auto queries = DatasetLoader::generateRandom(50, 3, 12);
+
+    KDTree reference(3, DistanceType::EUCLIDEAN, 2.0, 1);
+    reference.build(data);
+
+    for (int leafSize : {4, 16, 64}) {
+        KDTree tree(3, DistanceType::EUCLIDEAN, 2.0, leafSize);
+        tree.build(data);
+        assert(tree.getLeafSize() == leafSize);
+        assert(tree.height() < reference.height());
+
+        for (const auto& q : queries) {
+            auto expected = reference.kNearestNeighbors(q, 7);
+            auto actual = tree.kNearestNeighbors(q, 7);
+            assert(expected.size() == actual.size());
+            for (size_t i = 0; i < expected.size(); i++) {
+                assert(expected[i].coordinates == actual[i].coordinates);
+            }
+        }
+        assert(tree.search(data[123]) == true);
+        std::cout << " leafSize=" << leafSize << " height=" << tree.height()
+                  << " matches single-point leaves" << std::endl;
+    }
+
+    bool threw = false;
+    try {
+        KDTree invalid(3, DistanceType::EUCLIDEAN, 2.0, 0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << " leafSize=0 correctly rejected" << std::endl;
+}
+
+void testReducedDistanceSearch() {
+    std::cout << "\n=== Test 9: Reduced Distance Search (all metrics) ===" << std::endl;
+
+    // Small integer coordinates so Hamming distances are meaningful
+    auto data = DatasetLoader::generateRandom(1500, 4, 21);
+    for (auto& p : data) {
+        for (auto& x : p.coordinates) x = std::floor(x / 10.0);
+    }
+    auto queries = DatasetLoader::generateRandom(40, 4, 22);
+    for (auto& q : queries) {
+        for (auto& x : q.coordinates) x = std::floor(x / 10.0);
+    }
+
+    // The tree drops duplicate points, so brute force must too
+    std::vector<Point> uniqueData;
+    KDTree unique(4);
+    for (const auto& p : data) {
+        if (unique.insert(p)) uniqueData.push_back(p);
+    }
+
+    const int k = 6;
+    struct MetricCase { DistanceType type; double p; const char* name; };
+    std::vector<MetricCase> metrics = {
+        {DistanceType::EUCLIDEAN, 2.0, "euclidean"},
+        {DistanceType::MANHATTAN, 1.0, "manhattan"},
+        {DistanceType::HAMMING, 1.0, "hamming"},
+        {DistanceType::MINKOWSKI, 3.0, "minkowski(p=3)"},
+        {DistanceType::MINKOWSKI, 2.5, "minkowski(p=2.5)"},
+        {DistanceType::CHEBYSHEV, 1.0, "chebyshev"},
+    };
+
+    auto realDistance = [](const MetricCase& m, const Point& a, const Point& b) {
+        switch (m.type) {
+            case DistanceType::MANHATTAN: return DistanceMetrics::manhattan(a, b);
+            case DistanceType::HAMMING: return DistanceMetrics::hamming(a, b);
+            case DistanceType::MINKOWSKI: return DistanceMetrics::minkowski(a, b, m.p);
+            case DistanceType::CHEBYSHEV: return DistanceMetrics::chebyshev(a, b);
+            default: return DistanceMetrics::euclidean(a, b);
+        }
+    };
+
+    for (const auto& m : metrics) {
+        KDTree built(4, m.type, m.p);
+        built.build(data);
+        KDTree inserted(4, m.type, m.p);
+        for (const auto& p : data) inserted.insert(p);
+
+        for (const auto& q : queries) {
+            // Brute-force k smallest distances
+            std::vector<double> expected;
+            for (const auto& p : uniqueData) {
+                expected.push_back(realDistance(m, q, p));
+            }
+            std::sort(expected.begin(), expected.end());
+
+            for (KDTree* tree : {&built, &inserted}) {
+                // Small k uses the sorted array, large k the max-heap
+                for (int kk : {k, 40}) {
+                    auto neighbors = tree->kNearestNeighbors(q, kk);
+                    assert(neighbors.size() == static_cast<size_t>(kk));
+                    for (int i = 0; i < kk; i++) {
+                        assert(std::abs(realDistance(m, q, neighbors[i]) - expected[i]) < 1e-9);
+                    }
+                }
+                double nearest = realDistance(m, q, tree->nearestNeighbor(q));
+                assert(std::abs(nearest - expected[0]) < 1e-9);
+            }
+        }
+        std::cout << " " << m.name << ": k-NN matches brute force" << std::endl;
+    }
+}
+
+void testBatchedQueries() {
+    std::cout << "\n=== Test 10: Batched Multi-threaded k-NN ===" << std::endl;
+
+    auto data = DatasetLoader::generateRandom(5000, 4, 31);
+    auto queries = DatasetLoader::generateRandom(1000, 4, 32);
+    const int k = 7;
+
+    KDTree built(4);
+    built.build(data);
+    KDTree inserted(4);
+    for (const auto& p : data) inserted.insert(p);
+
+    for (KDTree* tree : {&built, &inserted}) {
+        // Serial reference, one query at a time
+        tree->resetDistanceCount();
+        std::vector<std::vector<Point>> expected;
+        for (const auto& q : queries) {
+            expected.push_back(tree->kNearestNeighbors(q, k));
+        }
+        long long serialCount = tree->getDistanceCount();
+
+        for (int threads : {1, 2, 4, 0}) {
+            tree->resetDistanceCount();
+            auto batch = tree->kNearestNeighborsBatch(queries, k, threads);
+
+            // Results in input order, identical to the serial search
+            assert(batch.size() == queries.size());
+            for (size_t i = 0; i < queries.size(); i++) {
+                assert(batch[i].size() == expected[i].size());
+                for (size_t j = 0; j < batch[i].size(); j++) {
+                    assert(batch[i][j].coordinates == expected[i][j].coordinates);
+                }
+            }
+
+            // Per-thread counters add up to the serial count
+            assert(tree->getDistanceCount() == serialCount);
+        }
+    }
+    std::cout << " 1, 2, 4 and all-core batches match serial queries" << std::endl;
+    std::cout << " Merged distance counts match serial count" << std::endl;
+
+    assert(built.kNearestNeighborsBatch({}, k, 4).empty());
+    std::cout << " Empty batch handled" << std::endl;
+}
+
+void testNeighborIndices() {
+    std::cout << "\n=== Test 11: Neighbor Indices and Distances ===" << std::endl;
+
+    auto data = DatasetLoader::generateRandom(3000, 3, 41);
+    auto queries = DatasetLoader::generateRandom(200, 3, 42);
+    const int k = 6;
+
+    KDTree built(3);
+    built.build(data);
+    KDTree inserted(3);
+    for (const auto& p : data) inserted.insert(p);
+
+    for (KDTree* tree : {&built, &inserted}) {
+        for (const auto& q : queries) {
+            auto points = tree->kNearestNeighbors(q, k);
+            auto neighbors = tree->kNearestNeighborIndices(q, k);
+
+            // Indices refer to the input sequence, distances are true metric values
+            assert(neighbors.size() == points.size());
+            for (size_t j = 0; j < neighbors.size(); j++) {
+                const Point& p = data[neighbors[j].index];
+                assert(p.coordinates == points[j].coordinates);
+                assert(std::abs(neighbors[j].distance - DistanceMetrics::euclidean(q, p)) < 1e-9);
+            }
+        }
+    }
+    std::cout << " Indices map back to the input points in nearest-first order" << std::endl;
+
+    auto batch = built.kNearestNeighborIndicesBatch(queries, k, 2);
+    assert(batch.size() == queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto single = built.kNearestNeighborIndices(queries[i], k);
+        assert(batch[i].size() == single.size());
+        for (size_t j = 0; j < single.size(); j++) {
+            assert(batch[i][j].index == single[j].index);
+        }
+    }
+    std::cout << " Batched indices match single queries" << std::endl;
+
+    // Indices survive removal (which rebuilds the pointer tree) and later inserts
+    built.remove(data[0]);
+    Point extra({0.5, 0.5, 0.5}, 1);
+    built.insert(extra);
+    auto nearest = built.kNearestNeighborIndices(extra, 1);
+    assert(nearest.size() == 1 && nearest[0].index == static_cast<int>(data.size()));
+    for (const auto& q : queries) {
+        for (const auto& neighbor : built.kNearestNeighborIndices(q, k)) {
+            assert(neighbor.index != 0);
+            if (neighbor.index < static_cast<int>(data.size())) {
+                assert(std::abs(neighbor.distance - DistanceMetrics::euclidean(q, data[neighbor.index])) < 1e-9);
+            }
+        }
+    }
+    std::cout << " Indices stay stable across remove and insert" << std::endl;
+
+    // Duplicates collapse onto the first occurrence
+    std::vector<Point> dupes = {Point({1.0, 1.0}, 0), Point({2.0, 2.0}, 1), Point({1.0, 1.0}, 2)};
+    KDTree dupTree(2);
+    dupTree.build(dupes);
+    auto dupNearest = dupTree.kNearestNeighborIndices(Point({1.0, 1.0}), 3);
+    assert(dupNearest.size() == 2 && dupNearest[0].index == 0 && dupNearest[1].index == 1);
+    std::cout << " Duplicate points keep their first index" << std::endl;
+
+    // Queries of another dimension are rejected, on the index and the linked tree
+    auto rejects = [](auto search) {
+        try {
+            search();
+        } catch (const std::invalid_argument&) {
+            return true;
+        }
+        return false;
+    };
+    Point shortQuery({1.0});
+    Dataset shortQueries(1);
+    shortQueries.addRow(shortQuery);
+    assert(rejects([&] { dupTree.kNearestNeighborIndices(shortQuery, 1); }));
+    assert(rejects([&] { dupTree.kNearestNeighbors(shortQuery, 1); }));
+    assert(rejects([&] { dupTree.nearestNeighbor(shortQuery); }));
+    assert(rejects([&] { dupTree.kNearestNeighborIndicesBatch(shortQueries, 1); }));
+    assert(rejects([&] { dupTree.kNearestNeighborsBatch({shortQuery}, 1); }));
+    assert(rejects([&] { built.kNearestNeighborIndices(Point({1.0, 2.0}), 1); }));
+    assert(!dupTree.search(shortQuery));
+    KNNKDTree knn(3, 2);
+    knn.fit(dupes);
+    assert(rejects([&] { knn.predict(shortQuery); }));
+    assert(rejects([&] { knn.predictWithMetrics(shortQuery); }));
+    assert(rejects([&] { knn.findKNearest(shortQuery); }));
+    assert(rejects([&] { knn.predictBatch(shortQueries); }));
+    assert(rejects([&] { knn.findKNearestIndicesBatch(std::vector<Point>{shortQuery}); }));
+    std::cout << " Queries of the wrong dimension throw std::invalid_argument" << std::endl;
+}
+
+void testDatasetBuild() {
+    std::cout << "\n=== Test 12: Build from a Dataset ===" << std::endl;
+
+    auto points = DatasetLoader::generateRandom(2000, 4, 51);
+    auto queryPoints = DatasetLoader::generateRandom(100, 4, 52);
+    Dataset data = Dataset::fromPoints(points);
+
+    // Building from the matrix gives the same index as building from Points
+    KDTree fromPoints(4);
+    fromPoints.build(points);
+    KDTree fromRows(4);
+    fromRows.build(data);
+    Dataset queries = Dataset::fromPoints(queryPoints);
+    auto batch = fromRows.kNearestNeighborIndicesBatch(queries, 5, 2);
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto expected = fromPoints.kNearestNeighborIndices(queryPoints[i], 5);
+        auto viaRow = fromRows.kNearestNeighborIndices(queries.row(i), 5);
+        assert(viaRow.size() == expected.size() && batch[i].size() == expected.size());
+        for (size_t j = 0; j < expected.size(); j++) {
+            assert(viaRow[j].index == expected[j].index);
+            assert(batch[i][j].index == expected[j].index);
+        }
+    }
+    std::cout << " KDTree built from a Dataset matches the Point build" << std::endl;
+}
+
+void testFixedDimensions() {
+    std::cout << "\n=== Test 13: Compile-time Dimension Specialization ===" << std::endl;
+
+    for (int dims : {2, 3, 4, 8, 16}) {
+        assert(Dimensions::withDimensions(dims, [](auto d) { return decltype(d)::value; }) == dims);
+    }
+    assert(Dimensions::withDimensions(5, [](auto d) { return decltype(d)::value; }) ==
+           Dimensions::DYNAMIC);
+    assert(Dimensions::count<Dimensions::DYNAMIC>(5) == 5);
+    std::cout << " Common dimensions map to fixed specializations" << std::endl;
+
+    // Specialized (2, 3, 4, 8, 16) and dynamic (5, 7) trees against brute force
+    for (int dims : {2, 3, 4, 5, 7, 8, 16}) {
+        auto data = DatasetLoader::generateRandom(600, dims, 70 + dims);
+        auto queries = DatasetLoader::generateRandom(20, dims, 90 + dims);
+        for (DistanceType type : {DistanceType::EUCLIDEAN, DistanceType::MANHATTAN,
+                                  DistanceType::CHEBYSHEV, DistanceType::MINKOWSKI}) {
+            KDTree tree(dims, type, 3.0, 4);
+            tree.build(data);
+            for (const auto& q : queries) {
+                std::vector<double> expected;
+                for (const auto& p : data) {
+                    expected.push_back(DistanceMetrics::reducedToDistance(
+                        DistanceMetrics::reducedDistance(q, p, type, 3.0), type, 3.0));
+                }
+                std::sort(expected.begin(), expected.end());
+
+                auto found = tree.kNearestNeighborIndices(q, 8);
+                assert(found.size() == 8);
+                for (size_t i = 0; i < found.size(); i++) {
+                    assert(std::abs(found[i].distance - expected[i]) < 1e-9);
+                }
+            }
+        }
+    }
+    std::cout << " Fixed and dynamic dimensions match brute force" << std::endl;
+}
+
+void testFloatStorage() {
+    std::cout << "\n=== Test 14: Float32 Storage and Mixed Accumulation ===" << std::endl;
+
+    // 3 axes run the fixed-dimension scan, 5 the per-axis column kernels
+    for (int dims : {3, 5}) {
+        auto data = DatasetLoader::generateRandom(2000, dims, 110 + dims);
+        auto queries = DatasetLoader::generateRandom(50, dims, 120 + dims);
+
+        KDTree reference(dims);
+        reference.build(data);
+        for (Precision precision : {Precision::FLOAT32, Precision::MIXED}) {
+            for (DistanceType type : {DistanceType::EUCLIDEAN, DistanceType::MANHATTAN,
+                                      DistanceType::CHEBYSHEV}) {
+                KDTree exact(dims, type);
+                exact.build(data);
+                KDTree tree(dims, type, 2.0, KDTree::DEFAULT_LEAF_SIZE, precision);
+                tree.build(data);
+                assert(tree.getPrecision() == precision);
+
+                for (const auto& q : queries) {
+                    auto expected = exact.kNearestNeighborIndices(q, 6);
+                    auto found = tree.kNearestNeighborIndices(q, 6);
+                    assert(found.size() == expected.size());
+                    for (size_t i = 0; i < found.size(); i++) {
+                        // Float rounding only matters relative to the coordinates (0..100)
+                        assert(std::abs(found[i].distance - expected[i].distance) < 1e-3);
+                    }
+                }
+            }
+
+            // Coordinates are half the size; nodes, labels and ids are unchanged
+            KDTree tree(dims, DistanceType::EUCLIDEAN, 2.0, KDTree::DEFAULT_LEAF_SIZE, precision);
+            tree.build(data);
+            assert(reference.indexBytes() - tree.indexBytes() == data.size() * dims * sizeof(float));
+
+            // Stored points are found at float precision, and the tree stays
+            // usable after converting back to linked nodes
+            assert(tree.search(data[7]));
+            Point extra(std::vector<double>(dims, 0.25), 1);
+            assert(tree.insert(extra));
+            assert(tree.search(extra));
+            assert(tree.kNearestNeighbors(extra, 1).front().coordinates == extra.coordinates);
+        }
+    }
+    std::cout << " float32 and mixed trees match the double tree within float precision" << std::endl;
+    std::cout << " Coordinate storage is halved" << std::endl;
+}
+
+void testParallelBuild() {
+    std::cout << "\n=== Test 15: Parallel Bulk Build ===" << std::endl;
+
+    // Small cutoffs force the parallel paths; heavy duplication exercises the
+    // equivalent-to-pivot partition
+    std::vector<int> values(20000);
+    for (size_t i = 0; i < values.size(); i++) values[i] = static_cast<int>((i * 7919) % 1009);
+    for (int threads : {1, 3, 4}) {
+        auto sorted = values;
+        Parallel::sort(sorted.begin(), sorted.end(), std::less<int>(), threads, 512);
+        assert(std::is_sorted(sorted.begin(), sorted.end()));
+
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+        for (size_t nth : {size_t(0), size_t(777), size_t(10000), values.size() - 1}) {
+            auto partitioned = values;
+            Parallel::nthElement(partitioned.begin(), partitioned.begin() + nth, partitioned.end(),
+                                 std::less<int>(), threads, 512);
+            assert(partitioned[nth] == expected[nth]);
+            for (size_t i = 0; i < nth; i++) assert(partitioned[i] <= partitioned[nth]);
+            for (size_t i = nth; i < values.size(); i++) assert(partitioned[i] >= partitioned[nth]);
+        }
+    }
+    std::cout << " Parallel sort and nth element match the serial algorithms" << std::endl;
+
+    // The pool's workers are reused across calls; calls nested in a worker
+    // or made from another thread while it is busy get threads of their own
+    std::vector<std::atomic<int>> hits(4000);
+    auto visit = [&](size_t begin, size_t end, int worker) {
+        assert(worker >= 0 && worker < 4);
+        for (size_t i = begin; i < end; i++) hits[i]++;
+    };
+    Parallel::forEachChunk(1000, 4, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; i++) hits[i]++;
+        Parallel::forEachChunk(3, 4, [&](size_t b, size_t e, int) {
+            for (size_t j = b; j < e; j++) hits[1000 + 3 * (begin / 10) + j]++;
+        }, 1);
+    }, 10);
+    std::thread other([&] { Parallel::forEachChunk(1000, 3, visit, 7); });
+    for (int round = 0; round < 50; round++) {
+        Parallel::forEachChunk(1000, 4, [&](size_t begin, size_t end, int worker) {
+            visit(begin + 3000, end + 3000, worker);
+        }, 9);
+    }
+    other.join();
+    for (size_t i = 0; i < 1300; i++) assert(hits[i] == (i < 1000 ? 2 : 1));
+    for (size_t i = 3000; i < 4000; i++) assert(hits[i] == 50);
+    bool threw = false;
+    try {
+        Parallel::forEachChunk(100, 4, [](size_t begin, size_t, int) {
+            if (begin == 50) throw std::runtime_error("chunk failed");
+        }, 10);
+    } catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << " Pooled, nested, concurrent and failing loops run every chunk once" << std::endl;
+
+    // Enough points for the top levels to be partitioned in parallel
+    auto data = DatasetLoader::generateRandom(100000, 3, 130);
+    for (size_t i = 0; i < 500; i++) data.push_back(data[i * 37]);
+    auto queries = DatasetLoader::generateRandom(100, 3, 131);
+
+    KDTree serial(3);
+    serial.build(data, 1);
+    for (int threads : {3, 4}) {
+        KDTree tree(3);
+        tree.build(data, threads);
+        assert(tree.indexBytes() == serial.indexBytes());
+        for (const auto& q : queries) {
+            auto expected = serial.kNearestNeighborIndices(q, 8);
+            auto found = tree.kNearestNeighborIndices(q, 8);
+            assert(found.size() == expected.size());
+            for (size_t i = 0; i < found.size(); i++) {
+                assert(found[i].index == expected[i].index);
+                assert(found[i].distance == expected[i].distance);
+            }
+        }
+    }
+    std::cout << " Trees built on 1, 3 and 4 threads return identical neighbors" << std::endl;
+
+    for (size_t j = 0; j < 10; j++) {
+        const Point& q = queries[j];
+        double best = INFINITY;
+        for (const auto& p : data) {
+            double dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+            best = std::min(best, std::sqrt(dx * dx + dy * dy + dz * dz));
+        }
+        assert(std::abs(serial.kNearestNeighborIndices(q, 1).front().distance - best) < 1e-9);
+    }
+    std::cout << " Nearest neighbors match brute force" << std::endl;
+}
+
+void testSplitRules() {
+    std::cout << "\n=== Test 16: Split Rules ===" << std::endl;
+
+    // Axis 0 spans 0..100000, the others 0..1: cyclic splits waste most levels
+    auto data = DatasetLoader::generateRandom(5000, 4, 140);
+    auto queries = DatasetLoader::generateRandom(100, 4, 141);
+    for (auto* points : {&data, &queries}) {
+        for (auto& p : *points) {
+            p.coordinates[0] *= 1000.0;
+            for (int d = 1; d < 4; d++) p.coordinates[d] /= 100.0;
+        }
+    }
+
+    KDTree cyclic(4);
+    cyclic.build(data);
+    for (const auto& q : queries) cyclic.kNearestNeighborIndices(q, 5);
+    assert(cyclic.getSplitRule() == SplitRule::CYCLIC);
+
+    for (SplitRule rule : {SplitRule::HIGHEST_VARIANCE, SplitRule::WIDEST_SPREAD,
+                           SplitRule::SLIDING_MIDPOINT}) {
+        for (DistanceType type : {DistanceType::EUCLIDEAN, DistanceType::MANHATTAN}) {
+            KDTree reference(4, type);
+            reference.build(data);
+            KDTree tree(4, type, 2.0, KDTree::DEFAULT_LEAF_SIZE, Precision::FLOAT64, rule);
+            tree.build(data);
+            for (const auto& q : queries) {
+                auto expected = reference.kNearestNeighborIndices(q, 5);
+                auto found = tree.kNearestNeighborIndices(q, 5);
+                assert(found.size() == expected.size());
+                for (size_t i = 0; i < found.size(); i++) {
+                    assert(std::abs(found[i].distance - expected[i].distance) < 1e-9);
+                }
+            }
+            if (type == DistanceType::EUCLIDEAN) {
+                assert(tree.getNodeVisitCount() < cyclic.getNodeVisitCount());
+                tree.resetNodeVisitCount();
+                assert(tree.getNodeVisitCount() == 0);
+            }
+            for (size_t i = 0; i < data.size(); i += 97) assert(tree.search(data[i]));
+        }
+    }
+    std::cout << " All rules find the exact neighbors" << std::endl;
+    std::cout << " Data-driven rules visit fewer nodes on skewed axes" << std::endl;
+
+    // Sliding midpoint on clustered data: every point stays reachable and
+    // the parallel build splits the same way
+    std::vector<Point> clustered;
+    for (const auto& p : DatasetLoader::generateRandom(70000, 3, 142)) {
+        Point q = p;
+        if (clustered.size() % 10 != 0) {
+            for (auto& x : q.coordinates) x = x / 1000.0;
+        }
+        clustered.push_back(q);
+    }
+    for (SplitRule rule : {SplitRule::HIGHEST_VARIANCE, SplitRule::SLIDING_MIDPOINT}) {
+        KDTree serial(3, DistanceType::EUCLIDEAN, 2.0, KDTree::DEFAULT_LEAF_SIZE,
+                      Precision::FLOAT64, rule);
+        serial.build(clustered, 1);
+        KDTree parallel(3, DistanceType::EUCLIDEAN, 2.0, KDTree::DEFAULT_LEAF_SIZE,
+                        Precision::FLOAT64, rule);
+        parallel.build(clustered, 4);
+        assert(serial.height() == parallel.height());
+        assert(serial.indexBytes() == parallel.indexBytes());
+        for (size_t i = 0; i < clustered.size(); i += 701) {
+            assert(parallel.search(clustered[i]));
+            auto expected = serial.kNearestNeighborIndices(clustered[i], 3);
+            auto found = parallel.kNearestNeighborIndices(clustered[i], 3);
+            assert(found.front().distance == 0.0);
+            for (size_t j = 0; j < found.size(); j++) {
+                assert(found[j].distance == expected[j].distance);
+            }
+        }
+    }
+    std::cout << " Parallel builds match serial builds under every rule" << std::endl;
+}
+
+void testNodeArena() {
+    std::cout << "\n=== Test 17: Node Arena ===" << std::endl;
+
+    NodeArena arena(KDNode::recordSize(3), 1024);
+    assert(arena.getRecordSize() % alignof(std::max_align_t) == 0);
+    std::vector<void*> records;
+    for (int i = 0; i < 100; i++) records.push_back(arena.allocate());
+    assert(arena.liveRecords() == 100);
+    size_t slabs = arena.slabCount();
+    assert(slabs > 1);
+
+    // Released records are reused before new slab space
+    arena.release(records[10]);
+    arena.release(records[20]);
+    assert(arena.allocate() == records[20]);
+    assert(arena.allocate() == records[10]);
+    assert(arena.liveRecords() == 100 && arena.slabCount() == slabs);
+
+    // A reservation fits in one slab, laid out in allocation order
+    arena.reserve(500);
+    char* first = static_cast<char*>(arena.allocate());
+    for (int i = 1; i < 500; i++) {
+        assert(arena.allocate() == first + i * arena.getRecordSize());
+    }
+    assert(arena.slabCount() == slabs + 1);
+    arena.clear();
+    assert(arena.slabCount() == 0 && arena.bytes() == 0 && arena.liveRecords() == 0);
+    std::cout << " Records are carved from slabs and recycled through the free list" << std::endl;
+
+    // Linked trees keep their nodes in the arena; remove() frees nodes for reuse
+    KDTree tree(3);
+    auto points = DatasetLoader::generateRandom(3000, 3, 150);
+    for (const auto& p : points) assert(tree.insert(p));
+    size_t bytes = tree.nodeBytes();
+    assert(bytes >= points.size() * KDNode::recordSize(3));
+    for (int round = 0; round < 3; round++) {
+        for (size_t i = 0; i < 1000; i++) tree.remove(points[i]);
+        for (size_t i = 0; i < 1000; i++) assert(!tree.search(points[i]));
+        for (size_t i = 0; i < 1000; i++) assert(tree.insert(points[i]));
+    }
+    assert(tree.nodeBytes() == bytes);
+    for (const auto& p : points) assert(tree.search(p));
+    auto nearest = tree.kNearestNeighbors(points[5], 1);
+    assert(nearest.front().coordinates == points[5].coordinates);
+    assert(nearest.front().label == points[5].label);
+
+    // A bulk build releases the linked nodes' slabs
+    tree.build(points);
+    assert(tree.nodeBytes() == 0);
+    std::cout << " remove() recycles nodes: no growth over insert/remove rounds" << std::endl;
+}
+
+void testIndexFiles() {
+    std::cout << "\n=== Test 18: Saved Index Files ===" << std::endl;
+
+    const char* path = "index_file_test.kdt";
+    auto points = DatasetLoader::generateRandom(5000, 4, 100);
+    points.push_back(points[7]);    // duplicate, dropped by the build
+    auto queries = DatasetLoader::generateRandom(50, 4, 100);
+
+    for (Precision precision : {Precision::FLOAT64, Precision::FLOAT32}) {
+        KDTree built(4, DistanceType::MINKOWSKI, 3.0, 8, precision, SplitRule::HIGHEST_VARIANCE);
+        built.build(points);
+        built.save(path);
+
+        auto loaded = KDTree::load(path);
+        assert(loaded->getDimensions() == 4);
+        assert(loaded->getDistanceMetric() == DistanceType::MINKOWSKI);
+        assert(loaded->getMinkowskiP() == 3.0);
+        assert(loaded->getLeafSize() == 8);
+        assert(loaded->getPrecision() == precision);
+        assert(loaded->getSplitRule() == SplitRule::HIGHEST_VARIANCE);
+        assert(loaded->indexBytes() == built.indexBytes());
+        assert(loaded->height() == built.height());
+        Point stored;
+        assert(loaded->pointOf(7, stored) && !loaded->pointOf(5000, stored));
+        assert(loaded->duplicatesOf(7) == 1 && loaded->duplicatesOf(5000) == 0);
+        assert(loaded->duplicatesOf(8) == 0);
+
+        for (const auto& q : queries) {
+            auto expected = built.kNearestNeighborIndices(q, 5);
+            auto found = loaded->kNearestNeighborIndices(q, 5);
+            assert(found.size() == expected.size());
+            for (size_t i = 0; i < found.size(); i++) {
+                assert(found[i].index == expected[i].index);
+                assert(found[i].distance == expected[i].distance);
+                assert(loaded->labelOf(found[i].index) == points[found[i].index].label);
+            }
+        }
+
+        // Changing a loaded tree copies the index out of the file first
+        Point extra({0.5, 0.5, 0.5, 0.5}, 9);
+        assert(loaded->insert(extra));
+        assert(loaded->search(extra));
+        assert(precision != Precision::FLOAT64 || loaded->search(points[0]));
+        assert(!loaded->hasIndex());
+    }
+    std::cout << " Loaded trees keep their configuration and answer like the built tree" << std::endl;
+
+    // Bad files are rejected
+    KDTree unbuilt(4);
+    bool threw = false;
+    try { unbuilt.save(path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << "not an index";
+    }
+    threw = false;
+    try { KDTree::load(path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    KDTree small(2);
+    small.build(DatasetLoader::generateRandom(100, 2, 10));
+    small.save(path);
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out << "trailing bytes";
+    }
+    threw = false;
+    try { KDTree::load(path); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { KDTree::load("missing_index_file.kdt"); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+    std::cout << " Unbuilt trees, foreign, truncated and missing files throw" << std::endl;
+
+    // Crafted files: counts whose byte sizes wrap around, node links and
+    // slots pointing outside the index. Patches are at offsets of the file
+    // header (dimensions 20, nextIndex 40, nodeCount 56, pointCount 64,
+    // nodesOffset 72, idsOffset 96, slotsOffset 104) and of FlatNode
+    // (disc 8, hison 12).
+    auto put = [](std::fstream& io, uint64_t offset, auto value) {
+        io.seekp(static_cast<std::streamoff>(offset));
+        io.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+    auto sectionAt = [](std::fstream& io, uint64_t headerOffset) {
+        uint64_t offset = 0;
+        io.seekg(static_cast<std::streamoff>(headerOffset));
+        io.read(reinterpret_cast<char*>(&offset), sizeof(offset));
+        return offset;
+    };
+    auto rejects = [&](auto corrupt) {
+        small.save(path);
+        {
+            std::fstream io(path, std::ios::binary | std::ios::in | std::ios::out);
+            corrupt(io);
+        }
+        try {
+            KDTree::load(path);
+        } catch (const std::runtime_error&) {
+            return true;
+        }
+        return false;
+    };
+    assert(!rejects([](std::fstream&) {}));
+    assert(rejects([&](std::fstream& io) {
+        put(io, 56, static_cast<uint64_t>(((1ull << 62) + 2) / 3));  // nodes: 16 bytes once wrapped
+    }));
+    assert(rejects([&](std::fstream& io) {
+        put(io, 40, static_cast<int32_t>(2147352580));              // columns: 64 bytes once wrapped
+        put(io, 64, static_cast<uint64_t>(2147352580));
+        put(io, 20, static_cast<int32_t>(1073807362));
+    }));
+    assert(rejects([&](std::fstream& io) {
+        put(io, sectionAt(io, 72) + 12, static_cast<int32_t>(1 << 30));  // root's HISON
+    }));
+    assert(rejects([&](std::fstream& io) {
+        put(io, sectionAt(io, 72) + 12, static_cast<int32_t>(0));        // cycle to the root
+    }));
+    assert(rejects([&](std::fstream& io) {
+        put(io, sectionAt(io, 72) + 8, static_cast<int32_t>(7));         // discriminator
+    }));
+    assert(rejects([&](std::fstream& io) {
+        put(io, sectionAt(io, 104), static_cast<int32_t>(100000));       // slot past the points
+    }));
+    assert(rejects([&](std::fstream& io) {
+        put(io, sectionAt(io, 104) + 4, static_cast<int32_t>(-2 - 100000));  // duplicate of it
+    }));
+    assert(rejects([&](std::fstream& io) {
+        put(io, sectionAt(io, 96), static_cast<int32_t>(100000000));     // id past the inputs
+    }));
+    assert(rejects([&](std::fstream& io) {
+        put(io, sectionAt(io, 96) + 4, static_cast<int32_t>(0));         // id of another point
+    }));
+    std::remove(path);
+    std::cout << " Wrapping counts, bad node links, slots and ids are rejected" << std::endl;
+}
+
 int main() {
     std::cout << "\n========================================" << std::endl;
     std::cout << "   KD-TREE COMPREHENSIVE TEST SUITE    " << std::endl;
@@ -269,6 +1082,18 @@ int main() {
         testKNearestNeighbors();
         test3DTree();
         testEdgeCases();
+        testBulkBuild();
+        testLeafBuckets();
+        testReducedDistanceSearch();
+        testBatchedQueries();
+        testNeighborIndices();
+        testDatasetBuild();
+        testFixedDimensions();
+        testFloatStorage();
+        testParallelBuild();
+        testSplitRules();
+        testNodeArena();
+        testIndexFiles();
 
         std::cout << "\n========================================" << std::endl;
         std::cout << "    ALL TESTS PASSED SUCCESSFULLY!    Q" << std::endl;
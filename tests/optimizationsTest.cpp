@@ -0,0 +1,372 @@
+#include <iostream>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <algorithm>
+#include <vector>
+#include "../include/optimizations/revised_kdtree.h"
+#include "../include/optimizations/quicknn.h"
+#include "../include/optimizations/blocked_brute_force.h"
+#include "../include/kdtree/kdtree.h"
+#include "../include/utils/point.h"
+#include "../include/utils/dataset_loader.h"
+#include "../include/utils/distance_metrics.h"
+
+struct MetricCase { DistanceType type; double p; const char* name; };
+
+static const std::vector<MetricCase> METRICS = {
+    {DistanceType::EUCLIDEAN, 2.0, "euclidean"},
+    {DistanceType::MANHATTAN, 1.0, "manhattan"},
+    {DistanceType::HAMMING, 1.0, "hamming"},
+    {DistanceType::MINKOWSKI, 3.0, "minkowski(p=3)"},
+    {DistanceType::MINKOWSKI, 2.5, "minkowski(p=2.5)"},
+    {DistanceType::CHEBYSHEV, 1.0, "chebyshev"},
+};
+
+static double realDistance(const MetricCase& m, const Point& a, const Point& b) {
+    switch (m.type) {
+        case DistanceType::MANHATTAN: return DistanceMetrics::manhattan(a, b);
+        case DistanceType::HAMMING: return DistanceMetrics::hamming(a, b);
+        case DistanceType::MINKOWSKI: return DistanceMetrics::minkowski(a, b, m.p);
+        case DistanceType::CHEBYSHEV: return DistanceMetrics::chebyshev(a, b);
+        default: return DistanceMetrics::euclidean(a, b);
+    }
+}
+
+// Small integer coordinates so Hamming distances and ties are meaningful
+static std::vector<Point> integerData(int n, int dims, int seed) {
+    auto data = DatasetLoader::generateRandom(n, dims, seed);
+    for (auto& p : data) {
+        for (auto& x : p.coordinates) x = std::floor(x / 10.0);
+    }
+    return data;
+}
+
+void testRevisedKNearest() {
+    std::cout << "\n=== Test 1: Revised k-d Tree k-NN (all metrics) ===" << std::endl;
+
+    auto data = integerData(2000, 4, 31);
+    auto queries = integerData(40, 4, 32);
+
+    for (const auto& m : METRICS) {
+        RevisedKDTree tree(4, m.type, m.p);
+        tree.fit(data);
+        assert(tree.size() == data.size());
+
+        for (const auto& q : queries) {
+            std::vector<double> expected;
+            for (const auto& p : data) {
+                expected.push_back(realDistance(m, q, p));
+            }
+            std::sort(expected.begin(), expected.end());
+
+            for (int k : {1, 7, 40}) {
+                auto neighbors = tree.kNearestNeighbors(q, k);
+                assert(neighbors.size() == static_cast<size_t>(k));
+                for (int i = 0; i < k; i++) {
+                    assert(std::abs(realDistance(m, q, neighbors[i]) - expected[i]) < 1e-9);
+                }
+            }
+            double nearest = realDistance(m, q, tree.nearestNeighbor(q));
+            assert(std::abs(nearest - expected[0]) < 1e-9);
+        }
+        std::cout << " " << m.name << ": k-NN matches brute force" << std::endl;
+    }
+}
+
+void testRevisedRangeSearch() {
+    std::cout << "\n=== Test 2: Revised k-d Tree Range Search ===" << std::endl;
+
+    auto data = DatasetLoader::generateRandom(3000, 3, 41);
+    auto queries = DatasetLoader::generateRandom(30, 3, 42);
+
+    for (const auto& m : METRICS) {
+        if (m.type == DistanceType::HAMMING) continue;  // continuous data
+
+        RevisedKDTree tree(3, m.type, m.p, 8);
+        tree.fit(data);
+
+        for (const auto& q : queries) {
+            for (double radius : {0.0, 5.0, 20.0, 60.0}) {
+                size_t expected = 0;
+                for (const auto& p : data) {
+                    if (realDistance(m, q, p) <= radius) expected++;
+                }
+                auto found = tree.rangeSearch(q, radius);
+                assert(found.size() == expected);
+                for (const auto& p : found) {
+                    assert(realDistance(m, q, p) <= radius + 1e-9);
+                }
+            }
+        }
+        std::cout << " " << m.name << ": range search matches brute force" << std::endl;
+    }
+
+    // Radius covering everything is answered from bounding boxes alone
+    RevisedKDTree tree(3);
+    tree.fit(data);
+    tree.resetDistanceCount();
+    assert(tree.rangeSearch(Point({50.0, 50.0, 50.0}), 1000.0).size() == data.size());
+    assert(tree.getDistanceCount() == 0);
+    std::cout << " Enclosing radius reported without distance calculations" << std::endl;
+}
+
+void testRevisedDistanceCount() {
+    std::cout << "\n=== Test 3: Distance Calculations vs KDTree ===" << std::endl;
+
+    auto data = DatasetLoader::generateRandom(20000, 8, 51);
+    auto queries = DatasetLoader::generateRandom(200, 8, 52);
+    const int k = 5;
+
+    KDTree kdtree(8);
+    kdtree.build(data);
+    RevisedKDTree revised(8);
+    revised.fit(data);
+
+    kdtree.resetDistanceCount();
+    revised.resetDistanceCount();
+    for (const auto& q : queries) {
+        auto a = kdtree.kNearestNeighbors(q, k);
+        auto b = revised.kNearestNeighbors(q, k);
+        assert(a.size() == b.size());
+        for (size_t i = 0; i < a.size(); i++) {
+            assert(std::abs(DistanceMetrics::euclidean(q, a[i]) -
+                            DistanceMetrics::euclidean(q, b[i])) < 1e-9);
+        }
+    }
+
+    double kdPerQuery = static_cast<double>(kdtree.getDistanceCount()) / queries.size();
+    double revisedPerQuery = static_cast<double>(revised.getDistanceCount()) / queries.size();
+    std::cout << " KDTree:        " << kdPerQuery << " distances/query" << std::endl;
+    std::cout << " RevisedKDTree: " << revisedPerQuery << " distances/query" << std::endl;
+    assert(revisedPerQuery < kdPerQuery);
+}
+
+void testRevisedEdgeCases() {
+    std::cout << "\n=== Test 4: Edge Cases ===" << std::endl;
+
+    RevisedKDTree empty(2);
+    empty.fit({});
+    assert(empty.kNearestNeighbors(Point({1.0, 1.0}), 3).empty());
+    assert(empty.rangeSearch(Point({1.0, 1.0}), 10.0).empty());
+    std::cout << " Empty tree returns no neighbors" << std::endl;
+
+    // Identical points must not be split forever
+    std::vector<Point> same(50, Point({2.0, 2.0}, 1));
+    RevisedKDTree duplicates(2, DistanceType::EUCLIDEAN, 2.0, 4);
+    duplicates.fit(same);
+    assert(duplicates.kNearestNeighbors(Point({0.0, 0.0}), 10).size() == 10);
+    std::cout << " Duplicate points handled" << std::endl;
+
+    // k larger than the dataset returns everything
+    RevisedKDTree small(2);
+    small.fit({Point({1.0, 1.0}, 0), Point({2.0, 2.0}, 1)});
+    assert(small.kNearestNeighbors(Point({0.0, 0.0}), 5).size() == 2);
+    std::cout << " k > n returns all points" << std::endl;
+
+    bool threw = false;
+    try {
+        RevisedKDTree invalid(2, DistanceType::EUCLIDEAN, 2.0, 0);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try {
+        small.fit({Point({1.0, 2.0, 3.0})});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << " Invalid leaf size and dimension mismatch rejected" << std::endl;
+}
+
+void testQuickNNBatch() {
+    std::cout << "\n=== Test 5: QuickNN Batched k-NN (3D) ===" << std::endl;
+
+    auto data = DatasetLoader::generateRandom(20000, 3, 61);
+    auto queries = DatasetLoader::generateRandom(2000, 3, 62);
+
+    // Duplicate points and queries sitting on training points
+    for (int i = 0; i < 200; i++) {
+        data.push_back(data[i]);
+        queries.push_back(data[i * 7]);
+    }
+
+    QuickNN quick(3);
+    quick.fit(data);
+    assert(quick.size() == data.size());
+    assert(quick.bucketCount() > 1);
+
+    const MetricCase& euclidean = METRICS[0];
+    for (int k : {1, 8, 50}) {
+        auto batch = quick.kNearestNeighborsBatch(queries, k);
+        assert(batch.size() == queries.size());
+
+        for (size_t qi = 0; qi < queries.size(); qi += 37) {
+            const Point& q = queries[qi];
+            std::vector<double> expected;
+            for (const auto& p : data) {
+                expected.push_back(realDistance(euclidean, q, p));
+            }
+            std::partial_sort(expected.begin(), expected.begin() + k, expected.end());
+
+            auto single = quick.kNearestNeighbors(q, k);
+            assert(batch[qi].size() == static_cast<size_t>(k));
+            assert(single.size() == static_cast<size_t>(k));
+            for (int i = 0; i < k; i++) {
+                assert(std::abs(realDistance(euclidean, q, batch[qi][i]) - expected[i]) < 1e-9);
+                assert(std::abs(realDistance(euclidean, q, single[i]) - expected[i]) < 1e-9);
+            }
+        }
+        std::cout << " k=" << k << ": batch and single queries match brute force" << std::endl;
+    }
+
+    // Batch streams buckets instead of searching query by query
+    KDTree kdtree(3);
+    kdtree.build(data);
+    kdtree.resetDistanceCount();
+    quick.resetDistanceCount();
+    for (const auto& q : queries) kdtree.kNearestNeighbors(q, 8);
+    quick.kNearestNeighborsBatch(queries, 8);
+    std::cout << " Distances/query: KDTree " << kdtree.getDistanceCount() / queries.size()
+              << ", QuickNN batch " << quick.getDistanceCount() / static_cast<long long>(queries.size())
+              << std::endl;
+}
+
+void testQuickNNEdgeCases() {
+    std::cout << "\n=== Test 6: QuickNN Edge Cases ===" << std::endl;
+
+    QuickNN empty;
+    empty.fit({});
+    assert(empty.kNearestNeighbors(Point({1.0, 1.0, 1.0}), 3).empty());
+    auto none = empty.kNearestNeighborsBatch({Point({1.0, 1.0, 1.0})}, 3);
+    assert(none.size() == 1 && none[0].empty());
+    std::cout << " Empty index returns no neighbors" << std::endl;
+
+    // k larger than a bucket and than the dataset
+    auto data = DatasetLoader::generateRandom(100, 3, 71);
+    QuickNN small(3, 4);
+    small.fit(data);
+    auto all = small.kNearestNeighborsBatch({Point({50.0, 50.0, 50.0})}, 500);
+    assert(all[0].size() == data.size());
+    std::cout << " k > n returns all points" << std::endl;
+
+    // Higher dimensions take the generic scan
+    auto data5d = DatasetLoader::generateRandom(3000, 5, 72);
+    QuickNN quick5d(5, 8);
+    quick5d.fit(data5d);
+    Point q({10.0, 20.0, 30.0, 40.0, 50.0});
+    Point expected = data5d[0];
+    for (const auto& p : data5d) {
+        if (DistanceMetrics::euclidean(q, p) < DistanceMetrics::euclidean(q, expected)) expected = p;
+    }
+    assert(std::abs(DistanceMetrics::euclidean(q, quick5d.nearestNeighbor(q)) -
+                    DistanceMetrics::euclidean(q, expected)) < 1e-9);
+    std::cout << " 5D nearest neighbor matches brute force" << std::endl;
+
+    bool threw = false;
+    try {
+        small.kNearestNeighborsBatch({Point({1.0, 2.0})}, 3);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        small.kNearestNeighbors(Point({1.0, 2.0}), 3);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << " Query dimension mismatch rejected" << std::endl;
+}
+
+void testBlockedBruteForce() {
+    std::cout << "\n=== Test 7: Blocked Brute-Force Batches ===" << std::endl;
+
+    const MetricCase& euclidean = METRICS[0];
+    for (int dims : {3, 17, 64}) {
+        // Not a multiple of the tile size, so the last tile is partial
+        auto data = DatasetLoader::generateRandom(3001, dims, 81);
+        auto queries = DatasetLoader::generateRandom(150, dims, 82);
+        queries.push_back(data[42]);
+
+        BlockedBruteForce brute(dims);
+        brute.fit(data);
+        assert(brute.size() == data.size());
+        assert(brute.getTileRows() % 16 == 0);
+
+        for (int threads : {1, 3}) {
+            auto batch = brute.kNearestNeighborsBatch(queries, 10, threads);
+            assert(batch.size() == queries.size());
+            for (size_t qi = 0; qi < queries.size(); qi++) {
+                std::vector<double> expected;
+                for (const auto& p : data) {
+                    expected.push_back(realDistance(euclidean, queries[qi], p));
+                }
+                std::partial_sort(expected.begin(), expected.begin() + 10, expected.end());
+
+                assert(batch[qi].size() == 10);
+                for (int i = 0; i < 10; i++) {
+                    const Point& p = data[batch[qi][i].index];
+                    assert(std::abs(batch[qi][i].distance - expected[i]) < 1e-6);
+                    assert(std::abs(realDistance(euclidean, queries[qi], p) - expected[i]) < 1e-6);
+                }
+            }
+            // A query on a training point finds it first
+            assert(batch.back()[0].index == 42 && batch.back()[0].distance < 1e-6);
+        }
+        std::cout << " " << dims << "D: batches on 1 and 3 threads match brute force" << std::endl;
+    }
+
+    auto data = DatasetLoader::generateRandom(50, 4, 83);
+    BlockedBruteForce small(4);
+    small.fit(data);
+    auto all = small.kNearestNeighborsBatch({data[0]}, 500);
+    assert(all[0].size() == data.size());
+    assert(small.kNearestNeighborsBatch(std::vector<Point>{}, 3).empty());
+    small.resetDistanceCount();
+    small.kNearestNeighborsBatch({data[0], data[1]}, 3);
+    assert(small.getDistanceCount() == 2 * 50);
+    std::cout << " k > n, empty batch and distance count handled" << std::endl;
+
+    bool threw = false;
+    try {
+        small.kNearestNeighborsBatch({Point({1.0, 2.0})}, 3);
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    assert(threw);
+    std::cout << " Query dimension mismatch rejected" << std::endl;
+}
+
+int main() {
+    std::cout << "\n========================================" << std::endl;
+    std::cout << "     OPTIMIZATIONS TEST SUITE           " << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    try {
+        testRevisedKNearest();
+        testRevisedRangeSearch();
+        testRevisedDistanceCount();
+        testRevisedEdgeCases();
+        testQuickNNBatch();
+        testQuickNNEdgeCases();
+        testBlockedBruteForce();
+
+        std::cout << "\n========================================" << std::endl;
+        std::cout << "    ALL TESTS PASSED SUCCESSFULLY!" << std::endl;
+        std::cout << "========================================\n" << std::endl;
+
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "\nTEST FAILED: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "\nTEST FAILED: Unknown error" << std::endl;
+        return 1;
+    }
+}
@@ -1,18 +1,36 @@
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 #include "../include/knn/knn_kdtree.h"
+#include "../include/utils/dataset_cache.h"
 #include "../include/utils/dataset_loader.h"
 
+// First line of a text file, empty if it cannot be read
+std::string readLine(const std::string& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
 void printUsage() {
     std::cout << "Usage: predict_knn_kdtree <csv_file> <k> [options]\n";
     std::cout << "\nOptions:\n";
     std::cout << "  --no-header                    CSV file has no header row\n";
     std::cout << "  --auto-encode                  Automatically detect and one-hot encode categorical columns\n";
-    std::cout << "  --distance <type>              Distance metric: euclidean, manhattan, hamming, minkowski\n";
+    std::cout << "  --distance <type>              Distance metric: euclidean, manhattan, hamming, minkowski, chebyshev\n";
     std::cout << "  --minkowski-p <p>              Parameter p for Minkowski distance (default: 2.0)\n";
     std::cout << "  --label-column <idx>           Index of label column (default: -1 for last column)\n";
+    std::cout << "  --leaf-size <n>                Maximum points per k-d tree leaf (default: 10)\n";
     std::cout << "  --predict-instance-index <idx> Index of instance to predict (0-based, within data rows)\n";
+    std::cout << "  --index <file>                 Save a k-d tree index of all rows to file, or reuse it for any\n";
+    std::cout << "                                 instance if it was built for the same CSV and options (as\n";
+    std::cout << "                                 recorded in <file>.key; rebuilt otherwise)\n";
     std::cout << "\nExample:\n";
     std::cout << "  predict_knn_kdtree dataset.csv 5 --predict-instance-index 10 --auto-encode --distance manhattan\n";
 }
@@ -32,8 +50,10 @@ int main(int argc, char* argv[]) {
     bool autoEncode = false;
     DistanceType distMetric = DistanceType::EUCLIDEAN;
     double minkowskiP = 2.0;
+    int leafSize = KDTree::DEFAULT_LEAF_SIZE;
     int labelColumn = -1;
     int predictInstanceIndex = -1;  // Index of instance to predict
+    std::string indexFile;          // Saved k-d tree index, reused across runs
 
     for (int i = 3; i < argc; i++) {
         std::string arg = argv[i];
@@ -47,12 +67,17 @@ int main(int argc, char* argv[]) {
             else if (dist == "manhattan") distMetric = DistanceType::MANHATTAN;
             else if (dist == "hamming") distMetric = DistanceType::HAMMING;
             else if (dist == "minkowski") distMetric = DistanceType::MINKOWSKI;
+            else if (dist == "chebyshev") distMetric = DistanceType::CHEBYSHEV;
         } else if (arg == "--minkowski-p" && i + 1 < argc) {
             minkowskiP = std::stod(argv[++i]);
         } else if (arg == "--label-column" && i + 1 < argc) {
             labelColumn = std::stoi(argv[++i]);
+        } else if (arg == "--leaf-size" && i + 1 < argc) {
+            leafSize = std::stoi(argv[++i]);
         } else if (arg == "--predict-instance-index" && i + 1 < argc) {
             predictInstanceIndex = std::stoi(argv[++i]);
+        } else if (arg == "--index" && i + 1 < argc) {
+            indexFile = argv[++i];
         }
     }
 
@@ -63,51 +88,109 @@ int main(int argc, char* argv[]) {
     }
 
     try {
-        // Load full dataset (including the instance to predict)
+        // Loads the full dataset (including the instance to predict)
+        auto loadAll = [&]() {
+            if (autoEncode) {
+                return DatasetLoader::loadCSVWithEncoding(csvFile, hasHeader, {}, labelColumn);
+            }
+            return DatasetLoader::loadCSV(csvFile, hasHeader, labelColumn);
+        };
         std::vector<Point> allData;
+        auto checkInstance = [&]() {
+            if (allData.empty()) {
+                throw std::runtime_error("Dataset is empty");
+            }
+            if (predictInstanceIndex >= static_cast<int>(allData.size())) {
+                throw std::runtime_error("Predict instance index " +
+                                         std::to_string(predictInstanceIndex) +
+                                         " is out of range (dataset has " +
+                                         std::to_string(allData.size()) + " instances)");
+            }
+        };
+
+        Point queryPoint;
+        KNNKDTree::PredictionResult result;
+        bool sharedIndex = false;
+        if (!indexFile.empty()) {
+            // The index covers every row and is shared by all instances: the
+            // query's own row is left out at search time. It is reused while
+            // its key file matches this CSV (size and modification time, no
+            // read) and these options; the query row is then read from the
+            // index itself, so a warm run never parses the CSV.
+            DatasetCache::Source source = DatasetCache::source(csvFile);
+            std::ostringstream key;
+            key.precision(std::numeric_limits<double>::max_digits10);
+            key << "predict_knn_kdtree source=" << source.size << ":" << source.modified
+                << " header=" << hasHeader << " encode=" << autoEncode
+                << " label=" << labelColumn << " distance=" << static_cast<int>(distMetric)
+                << " p=" << minkowskiP << " leaf=" << leafSize;
+            std::string indexKey = key.str();
+
+            std::unique_ptr<KNNKDTree> knn;
+            if (readLine(indexFile + ".key") == indexKey) {
+                // Reuse the saved index: mapped, not rebuilt
+                knn = KNNKDTree::load(indexFile, k);
+                if (knn->getDistanceMetric() != distMetric || knn->getLeafSize() != leafSize ||
+                    (distMetric == DistanceType::MINKOWSKI &&
+                     knn->getMinkowskiP() != minkowskiP)) {
+                    std::cerr << "Error: Index " << indexFile
+                              << " does not match its key file (distance or leaf size)\n";
+                    return 1;
+                }
+            } else {
+                allData = loadAll();
+                checkInstance();
+                int dims = allData[0].dimensions();
+                knn = std::make_unique<KNNKDTree>(k, dims, distMetric, minkowskiP, leafSize);
+                knn->fit(allData);
+
+                // The old key goes first, so it never describes a newer index
+                std::remove((indexFile + ".key").c_str());
+                knn->save(indexFile);
+                std::ofstream(indexFile + ".key") << indexKey << "\n";
+            }
 
-        if (autoEncode) {
-            allData = DatasetLoader::loadCSVWithEncoding(csvFile, hasHeader, {}, labelColumn);
-        } else {
-            allData = DatasetLoader::loadCSV(csvFile, hasHeader, labelColumn);
-        }
-
-        if (allData.empty()) {
-            std::cerr << "Error: Dataset is empty\n";
-            return 1;
-        }
-
-        if (predictInstanceIndex >= static_cast<int>(allData.size())) {
-            std::cerr << "Error: Predict instance index " << predictInstanceIndex
-                      << " is out of range (dataset has " << allData.size() << " instances)\n";
-            return 1;
+            // Leaving the row out is exact unless the index collapsed it with
+            // duplicate rows (the training set without it would keep one of
+            // them); those instances take the per-instance build below
+            sharedIndex = knn->trainingPoint(predictInstanceIndex, queryPoint) &&
+                          knn->trainingDuplicates(predictInstanceIndex) == 0;
+            if (sharedIndex) {
+                result = knn->predictWithMetrics(queryPoint, predictInstanceIndex);
+            }
         }
+        if (!sharedIndex) {
+            if (allData.empty()) {
+                allData = loadAll();
+            }
+            checkInstance();
 
-        // Extract the instance to predict
-        Point queryPoint = allData[predictInstanceIndex];
+            // Extract the instance to predict
+            queryPoint = allData[predictInstanceIndex];
 
-        // Create training data (all instances EXCEPT the one to predict)
-        std::vector<Point> trainingData;
-        trainingData.reserve(allData.size() - 1);
+            // Create training data (all instances EXCEPT the one to predict)
+            std::vector<Point> trainingData;
+            trainingData.reserve(allData.size() - 1);
 
-        for (size_t i = 0; i < allData.size(); i++) {
-            if (static_cast<int>(i) != predictInstanceIndex) {
-                trainingData.push_back(allData[i]);
+            for (size_t i = 0; i < allData.size(); i++) {
+                if (static_cast<int>(i) != predictInstanceIndex) {
+                    trainingData.push_back(allData[i]);
+                }
             }
-        }
 
-        if (trainingData.empty()) {
-            std::cerr << "Error: No training data available\n";
-            return 1;
-        }
+            if (trainingData.empty()) {
+                std::cerr << "Error: No training data available\n";
+                return 1;
+            }
 
-        // Train KNN on training data (excluding the query instance)
-        int dims = trainingData[0].dimensions();
-        KNNKDTree knn(k, dims, distMetric, minkowskiP);
-        knn.fit(trainingData);
+            // Train KNN on training data (excluding the query instance)
+            int dims = trainingData[0].dimensions();
+            KNNKDTree knn(k, dims, distMetric, minkowskiP, leafSize);
+            knn.fit(trainingData);
 
-        // Predict
-        auto result = knn.predictWithMetrics(queryPoint);
+            // Predict
+            result = knn.predictWithMetrics(queryPoint);
+        }
 
         // Output results as JSON
         std::cout << "{\n";
@@ -10,11 +10,13 @@ void printUsage() {
     std::cout << "\nOptions:\n";
     std::cout << "  --no-header            CSV file has no header row\n";
     std::cout << "  --auto-encode          Automatically detect and one-hot encode categorical columns\n";
-    std::cout << "  --distance <type>      Distance metric: euclidean, manhattan, hamming, minkowski\n";
+    std::cout << "  --distance <type>      Distance metric: euclidean, manhattan, hamming, minkowski, chebyshev\n";
     std::cout << "  --minkowski-p <p>      Parameter p for Minkowski distance (default: 2.0)\n";
     std::cout << "  --test-ratio <r>       Test set ratio (default: 0.2)\n";
     std::cout << "  --output <file>        Output JSON file for metrics (default: metrics.json)\n";
     std::cout << "  --label-column <idx>   Index of label column (default: -1 for last column, 0 for first)\n";
+    std::cout << "  --precision <type>     Coordinate storage: float64, float32, mixed (float32 storage,\n";
+    std::cout << "                         double accumulation) (default: float64)\n";
     std::cout << "\nExample:\n";
     std::cout << "  test_knn_basic iris.csv 5 --auto-encode --distance manhattan\n";
     std::cout << "  test_knn_basic letter.csv 3 --auto-encode --label-column 0\n";
@@ -37,6 +39,7 @@ int main(int argc, char* argv[]) {
     double testRatio = 0.2;
     std::string outputFile = "metrics.json";
     int labelColumn = -1;  // -1 means last column
+    Precision precision = Precision::FLOAT64;
 
     for (int i = 3; i < argc; i++) {
         std::string arg = argv[i];
@@ -50,6 +53,7 @@ int main(int argc, char* argv[]) {
             else if (dist == "manhattan") distMetric = DistanceType::MANHATTAN;
             else if (dist == "hamming") distMetric = DistanceType::HAMMING;
             else if (dist == "minkowski") distMetric = DistanceType::MINKOWSKI;
+            else if (dist == "chebyshev") distMetric = DistanceType::CHEBYSHEV;
         } else if (arg == "--minkowski-p" && i + 1 < argc) {
             minkowskiP = std::stod(argv[++i]);
         } else if (arg == "--test-ratio" && i + 1 < argc) {
@@ -58,6 +62,11 @@ int main(int argc, char* argv[]) {
             outputFile = argv[++i];
         } else if (arg == "--label-column" && i + 1 < argc) {
             labelColumn = std::stoi(argv[++i]);
+        } else if (arg == "--precision" && i + 1 < argc) {
+            std::string type = argv[++i];
+            if (type == "float64") precision = Precision::FLOAT64;
+            else if (type == "float32") precision = Precision::FLOAT32;
+            else if (type == "mixed") precision = Precision::MIXED;
         }
     }
 
@@ -97,7 +106,7 @@ int main(int argc, char* argv[]) {
         std::cout << "\nTraining KNN..." << std::endl;
         auto startTrain = std::chrono::high_resolution_clock::now();
 
-        KNNBasic knn(k, distMetric, minkowskiP);
+        KNNBasic knn(k, distMetric, minkowskiP, precision);
         knn.fit(train);
 
         auto endTrain = std::chrono::high_resolution_clock::now();
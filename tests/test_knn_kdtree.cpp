@@ -10,11 +10,18 @@ void printUsage() {
     std::cout << "\nOptions:\n";
     std::cout << "  --no-header            CSV file has no header row\n";
     std::cout << "  --auto-encode          Automatically detect and one-hot encode categorical columns\n";
-    std::cout << "  --distance <type>      Distance metric: euclidean, manhattan, hamming, minkowski\n";
+    std::cout << "  --distance <type>      Distance metric: euclidean, manhattan, hamming, minkowski, chebyshev\n";
     std::cout << "  --minkowski-p <p>      Parameter p for Minkowski distance (default: 2.0)\n";
     std::cout << "  --test-ratio <r>       Test set ratio (default: 0.2)\n";
     std::cout << "  --output <file>        Output JSON file for metrics (default: metrics_kdtree.json)\n";
     std::cout << "  --label-column <idx>   Index of label column (default: -1 for last column, 0 for first)\n";
+    std::cout << "  --leaf-size <n>        Maximum points per k-d tree leaf (default: 10)\n";
+    std::cout << "  --threads <n>          Worker threads for test queries (default: 1, 0 = all cores)\n";
+    std::cout << "  --precision <type>     Coordinate storage: float64, float32, mixed (float32 storage,\n";
+    std::cout << "                         double accumulation) (default: float64)\n";
+    std::cout << "  --split <rule>         k-d tree split rule: cyclic, variance (highest variance axis),\n";
+    std::cout << "                         spread (widest spread axis), midpoint (sliding midpoint)\n";
+    std::cout << "                         (default: cyclic)\n";
     std::cout << "\nExample:\n";
     std::cout << "  test_knn_kdtree iris.csv 5 --auto-encode --distance manhattan\n";
     std::cout << "  test_knn_kdtree letter.csv 3 --auto-encode --label-column 0\n";
@@ -36,6 +43,10 @@ int main(int argc, char* argv[]) {
     double minkowskiP = 2.0;
     double testRatio = 0.2;
     std::string outputFile = "metrics_kdtree.json";
+    int leafSize = KDTree::DEFAULT_LEAF_SIZE;
+    Precision precision = Precision::FLOAT64;
+    SplitRule splitRule = SplitRule::CYCLIC;
+    int numThreads = 1;
     int labelColumn = -1;  // -1 means last column
 
     for (int i = 3; i < argc; i++) {
@@ -50,6 +61,7 @@ int main(int argc, char* argv[]) {
             else if (dist == "manhattan") distMetric = DistanceType::MANHATTAN;
             else if (dist == "hamming") distMetric = DistanceType::HAMMING;
             else if (dist == "minkowski") distMetric = DistanceType::MINKOWSKI;
+            else if (dist == "chebyshev") distMetric = DistanceType::CHEBYSHEV;
         } else if (arg == "--minkowski-p" && i + 1 < argc) {
             minkowskiP = std::stod(argv[++i]);
         } else if (arg == "--test-ratio" && i + 1 < argc) {
@@ -58,6 +70,21 @@ int main(int argc, char* argv[]) {
             outputFile = argv[++i];
         } else if (arg == "--label-column" && i + 1 < argc) {
             labelColumn = std::stoi(argv[++i]);
+        } else if (arg == "--precision" && i + 1 < argc) {
+            std::string type = argv[++i];
+            if (type == "float64") precision = Precision::FLOAT64;
+            else if (type == "float32") precision = Precision::FLOAT32;
+            else if (type == "mixed") precision = Precision::MIXED;
+        } else if (arg == "--split" && i + 1 < argc) {
+            std::string rule = argv[++i];
+            if (rule == "cyclic") splitRule = SplitRule::CYCLIC;
+            else if (rule == "variance") splitRule = SplitRule::HIGHEST_VARIANCE;
+            else if (rule == "spread") splitRule = SplitRule::WIDEST_SPREAD;
+            else if (rule == "midpoint") splitRule = SplitRule::SLIDING_MIDPOINT;
+        } else if (arg == "--leaf-size" && i + 1 < argc) {
+            leafSize = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            numThreads = std::stoi(argv[++i]);
         }
     }
 
@@ -98,7 +125,7 @@ int main(int argc, char* argv[]) {
         auto startTrain = std::chrono::high_resolution_clock::now();
 
         int dims = data[0].dimensions();
-        KNNKDTree knn(k, dims, distMetric, minkowskiP);
+        KNNKDTree knn(k, dims, distMetric, minkowskiP, leafSize, precision, splitRule);
         knn.fit(train);
 
         auto endTrain = std::chrono::high_resolution_clock::now();
@@ -110,13 +137,10 @@ int main(int argc, char* argv[]) {
         auto startTest = std::chrono::high_resolution_clock::now();
 
         std::vector<int> true_labels;
-        std::vector<int> predicted_labels;
-
         for (const auto& point : test) {
-            int prediction = knn.predict(point);
             true_labels.push_back(point.label);
-            predicted_labels.push_back(prediction);
         }
+        std::vector<int> predicted_labels = knn.predictBatch(test, numThreads);
 
         auto endTest = std::chrono::high_resolution_clock::now();
         auto testTime = std::chrono::duration_cast<std::chrono::milliseconds>(endTest - startTest);
@@ -125,6 +149,9 @@ int main(int argc, char* argv[]) {
         std::cout << "Average prediction time: "
                   << (static_cast<double>(testTime.count()) / test.size())
                   << " ms/sample" << std::endl;
+        std::cout << "Average node visits: "
+                  << (static_cast<double>(knn.getNodeVisitCount()) / test.size())
+                  << " per sample" << std::endl;
 
         // Evaluate metrics
         std::cout << "\nEvaluating metrics..." << std::endl;